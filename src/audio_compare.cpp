@@ -0,0 +1,39 @@
+#include "audio_compare.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+//! Compare rendered audio against a reference.
+/*!
+ *  Samples that differ by no more than the tolerance are treated as equal.
+ *  The first sample outside the tolerance is reported; if there is none but
+ *  the lengths differ, the end of the shorter buffer is reported instead.
+ */
+Audio_Difference compare_audio(const int16_t* expected, size_t expected_frames,
+	const int16_t* actual, size_t actual_frames, int channels, int tolerance)
+{
+	Audio_Difference diff = {true, 0, -1, 0, 0, 0, 0};
+	size_t frames = std::min(expected_frames, actual_frames);
+	for(size_t i = 0; i < frames * channels; i++)
+	{
+		int difference = std::abs(expected[i] - actual[i]);
+		diff.max_difference = std::max(diff.max_difference, difference);
+		if(difference <= tolerance)
+			continue;
+		if(diff.matches)
+		{
+			diff.matches = false;
+			diff.first_frame = i / channels;
+			diff.channel = i % channels;
+			diff.expected = expected[i];
+			diff.actual = actual[i];
+		}
+		diff.differing_samples++;
+	}
+	if(diff.matches && expected_frames != actual_frames)
+	{
+		diff.matches = false;
+		diff.first_frame = frames;
+	}
+	return diff;
+}
@@ -0,0 +1,22 @@
+#ifndef AUDIO_COMPARE_H
+#define AUDIO_COMPARE_H
+
+#include <cstdint>
+#include <cstddef>
+
+//! Difference between two interleaved PCM buffers
+struct Audio_Difference
+{
+	bool matches;				// true if every sample is within the tolerance and the lengths are equal
+	size_t first_frame;			// first frame outside the tolerance, or where the shorter buffer ends
+	int channel;				// channel of the first difference, -1 if only the length differs
+	int expected;
+	int actual;
+	int max_difference;
+	size_t differing_samples;	// samples outside the tolerance
+};
+
+Audio_Difference compare_audio(const int16_t* expected, size_t expected_frames,
+	const int16_t* actual, size_t actual_frames, int channels, int tolerance = 0);
+
+#endif
@@ -0,0 +1,193 @@
+#include "audio_decoder.h"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <memory>
+#include <algorithm>
+
+#include <mpg123.h>
+#include <FLAC/stream_decoder.h>
+#include <vorbis/vorbisfile.h>
+
+//! Size of the blocks decoded at a time, in bytes.
+static const size_t decode_block_size = 64 * 1024;
+
+static std::string get_extension(const std::string& filename)
+{
+	size_t dot_pos = filename.find_last_of('.');
+	if(dot_pos == std::string::npos)
+		return "";
+	std::string ext = filename.substr(dot_pos + 1);
+	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+	return ext;
+}
+
+static Wave_Data decode_mp3(const std::string& filename)
+{
+	static bool init = (mpg123_init() == MPG123_OK);
+	if(!init)
+		throw std::runtime_error("Failed to initialize MP3 decoder");
+
+	std::unique_ptr<mpg123_handle, decltype(&mpg123_delete)> handle(mpg123_new(NULL, NULL), &mpg123_delete);
+	if(!handle || mpg123_open(handle.get(), filename.c_str()) != MPG123_OK)
+		throw std::runtime_error("Failed to open MP3 file");
+
+	long rate;
+	int channels, encoding;
+	if(mpg123_getformat(handle.get(), &rate, &channels, &encoding) != MPG123_OK)
+	{
+		mpg123_close(handle.get());
+		throw std::runtime_error("Failed to read MP3 format");
+	}
+
+	// Always decode to signed 16-bit at the native rate
+	mpg123_format_none(handle.get());
+	mpg123_format(handle.get(), rate, channels, MPG123_ENC_SIGNED_16);
+
+	Wave_Data wave = {};
+	wave.sample_rate = rate;
+	wave.channels = channels;
+
+	off_t length = mpg123_length(handle.get());
+	if(length > 0)
+		wave.samples.reserve(length * channels);
+
+	std::vector<int16_t> buffer(decode_block_size / sizeof(int16_t));
+	int status;
+	do
+	{
+		size_t done = 0;
+		status = mpg123_read(handle.get(), (unsigned char*)buffer.data(), buffer.size() * sizeof(int16_t), &done);
+		wave.samples.insert(wave.samples.end(), buffer.begin(), buffer.begin() + done / sizeof(int16_t));
+	}
+	while(status == MPG123_OK || status == MPG123_NEW_FORMAT);
+
+	mpg123_close(handle.get());
+	if(status != MPG123_DONE && wave.samples.empty())
+		throw std::runtime_error(std::string("MP3 decoding failed: ") + mpg123_plain_strerror(status));
+	return wave;
+}
+
+static FLAC__StreamDecoderWriteStatus flac_write(const FLAC__StreamDecoder* decoder,
+	const FLAC__Frame* frame, const FLAC__int32* const buffer[], void* client_data)
+{
+	Wave_Data* wave = (Wave_Data*)client_data;
+	unsigned int channels = frame->header.channels;
+	unsigned int length = frame->header.blocksize;
+	int shift = frame->header.bits_per_sample - 16;
+
+	if(!wave->channels)
+	{
+		wave->channels = channels;
+		wave->sample_rate = frame->header.sample_rate;
+	}
+	else if(wave->channels != channels)
+	{
+		return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+	}
+
+	size_t position = wave->samples.size();
+	wave->samples.resize(position + length * channels);
+	int16_t* output = &wave->samples[position];
+	for(unsigned int c = 0; c < channels; c++)
+	{
+		const FLAC__int32* input = buffer[c];
+		if(shift >= 0)
+		{
+			for(unsigned int i = 0; i < length; i++)
+				output[i * channels + c] = input[i] >> shift;
+		}
+		else
+		{
+			for(unsigned int i = 0; i < length; i++)
+				output[i * channels + c] = input[i] * (1 << -shift);
+		}
+	}
+	return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+}
+
+static void flac_metadata(const FLAC__StreamDecoder* decoder, const FLAC__StreamMetadata* metadata, void* client_data)
+{
+	Wave_Data* wave = (Wave_Data*)client_data;
+	if(metadata->type == FLAC__METADATA_TYPE_STREAMINFO)
+		wave->samples.reserve(metadata->data.stream_info.total_samples * metadata->data.stream_info.channels);
+}
+
+static void flac_error(const FLAC__StreamDecoder* decoder, FLAC__StreamDecoderErrorStatus status, void* client_data)
+{
+}
+
+static Wave_Data decode_flac(const std::string& filename)
+{
+	std::unique_ptr<FLAC__StreamDecoder, decltype(&FLAC__stream_decoder_delete)> decoder(FLAC__stream_decoder_new(), &FLAC__stream_decoder_delete);
+	if(!decoder)
+		throw std::runtime_error("Failed to initialize FLAC decoder");
+
+	Wave_Data wave = {};
+	if(FLAC__stream_decoder_init_file(decoder.get(), filename.c_str(), flac_write, flac_metadata, flac_error, &wave)
+		!= FLAC__STREAM_DECODER_INIT_STATUS_OK)
+		throw std::runtime_error("Failed to open FLAC file");
+
+	bool ok = FLAC__stream_decoder_process_until_end_of_stream(decoder.get());
+	FLAC__stream_decoder_finish(decoder.get());
+	if(!ok && wave.samples.empty())
+		throw std::runtime_error("FLAC decoding failed");
+	return wave;
+}
+
+static Wave_Data decode_ogg(const std::string& filename)
+{
+	OggVorbis_File file;
+	if(ov_fopen(filename.c_str(), &file) != 0)
+		throw std::runtime_error("Failed to open Ogg Vorbis file");
+
+	vorbis_info* info = ov_info(&file, -1);
+	Wave_Data wave = {};
+	wave.sample_rate = info->rate;
+	wave.channels = info->channels;
+
+	ogg_int64_t length = ov_pcm_total(&file, -1);
+	if(length > 0)
+		wave.samples.reserve(length * wave.channels);
+
+	std::vector<int16_t> buffer(decode_block_size / sizeof(int16_t));
+	int bitstream = 0;
+	long read;
+	while((read = ov_read(&file, (char*)buffer.data(), buffer.size() * sizeof(int16_t), 0, 2, 1, &bitstream)) > 0)
+		wave.samples.insert(wave.samples.end(), buffer.begin(), buffer.begin() + read / sizeof(int16_t));
+
+	ov_clear(&file);
+	if(wave.samples.empty())
+		throw std::runtime_error("Ogg Vorbis decoding failed");
+	return wave;
+}
+
+//! Load and decode an audio file.
+/*!
+ *  WAV, MP3, FLAC and Ogg Vorbis files are decoded in-process, so no
+ *  external tools are needed.
+ *
+ *  \exception std::runtime_error if the file can't be decoded.
+ */
+Wave_Data load_audio_file(const std::string& filename)
+{
+	std::string ext = get_extension(filename);
+	if(ext == "wav")
+		return load_wave_file(filename);
+	if(ext == "mp3")
+		return decode_mp3(filename);
+	if(ext == "flac")
+		return decode_flac(filename);
+	if(ext == "ogg")
+		return decode_ogg(filename);
+	// Could still be a WAV file with a different extension
+	try
+	{
+		return load_wave_file(filename);
+	}
+	catch(std::exception&)
+	{
+		throw std::runtime_error("Unsupported audio file format");
+	}
+}
@@ -0,0 +1,13 @@
+#ifndef AUDIO_DECODER_H
+#define AUDIO_DECODER_H
+
+#include <string>
+
+#include "wave_loader.h"
+
+//! File extensions accepted by load_audio_file(), in file dialog format.
+#define AUDIO_FILE_FILTER ".wav;.mp3;.flac;.ogg"
+
+Wave_Data load_audio_file(const std::string& filename);
+
+#endif
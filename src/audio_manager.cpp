@@ -5,6 +5,9 @@
 #include <typeinfo>
 
 #include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
 
 #if defined(LOCAL_LIBVGM)
 #include "audio/AudioStream.h"
@@ -23,7 +26,15 @@ Audio_Manager::Audio_Manager()
 	, sample_size(4)
 	, volume(1.0)
 	, converted_volume(0x100)
+	, bus_volume{1.0, 1.0}
+	, converted_bus_volume{0x100, 0x100}
+	, buffer_length(40)
 	, streams()
+	, finished_streams()
+	, mixer_pool(nullptr)
+	, mix_buffer()
+	, stream_buffers()
+	, mix_sample_count(0)
 	, window_handle(nullptr)
 	, driver_handle(nullptr)
 	, waiting_for_handle(false)
@@ -42,6 +53,12 @@ Audio_Manager::Audio_Manager()
 		audio_initialized = true;
 		enumerate_drivers();
 	}
+
+	// Start threads for mixing multiple streams in parallel. The audio
+	// thread also renders streams, so one core is left for it.
+	unsigned int thread_count = std::thread::hardware_concurrency();
+	if(thread_count > 1)
+		mixer_pool = std::make_unique<Mixer_Pool>(std::min(thread_count - 1, 3u));
 }
 
 //! get the singleton instance of Audio_Manager
@@ -202,7 +219,8 @@ int Audio_Manager::set_sample_rate(uint32_t new_sample_rate)
 //! Set global volume
 void Audio_Manager::set_volume(float new_volume)
 {
-	volume = volume;
+	std::lock_guard<std::mutex> lock(mutex);
+	volume = new_volume;
 	converted_volume = volume * 256.0;
 }
 
@@ -212,20 +230,63 @@ float Audio_Manager::get_volume() const
 	return volume;
 }
 
+//! Set the volume of a mixer bus
+void Audio_Manager::set_bus_volume(Audio_Stream::Bus bus, float new_volume)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	bus_volume[bus] = new_volume;
+	converted_bus_volume[bus] = new_volume * 256.0;
+}
+
+//! Get the volume of a mixer bus
+float Audio_Manager::get_bus_volume(Audio_Stream::Bus bus) const
+{
+	return bus_volume[bus];
+}
+
 //! Add an audio stream
 int Audio_Manager::add_stream(std::shared_ptr<Audio_Stream> stream)
 {
+	reap_streams();
+
 	std::lock_guard<std::mutex> lock(mutex);
 	stream->setup_stream(sample_rate);
 	printf("Adding stream %s\n", typeid(*stream).name());
 	streams.push_back(stream);
+	// Make sure that the audio thread never needs to allocate when it
+	// removes a stream.
+	finished_streams.reserve(streams.size());
 	return 0;
 }
 
+//! Stop and release streams that have finished playing.
+/*!
+ *  The audio thread only moves finished streams to a list, since stopping
+ *  a stream may block (Buffered_Stream waits for its producer thread).
+ *  This should be called regularly from the UI thread.
+ */
+void Audio_Manager::reap_streams()
+{
+	std::vector<std::shared_ptr<Audio_Stream>> reaped;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(finished_streams.empty())
+			return;
+		reaped = finished_streams;
+		finished_streams.clear();
+	}
+	for(auto&& stream : reaped)
+	{
+		printf("Removing stream %s\n", typeid(*stream).name());
+		stream->stop_stream();
+	}
+}
+
 //! Kill all streams and close audio system
 void Audio_Manager::clean_up()
 {
 	close_driver();
+	reap_streams();
 	if(audio_initialized)
 		Audio_Deinit();
 }
@@ -377,29 +438,94 @@ inline int16_t Audio_Manager::clip16(int32_t input)
 	return input;
 }
 
-uint32_t Audio_Manager::callback(void* drv_struct, void* user_param, uint32_t buf_size, void* data)
+//! Render one stream into its own buffer. Called by Mixer_Pool.
+void Audio_Manager::render_stream(void* context, unsigned int index)
 {
-	Audio_Manager& am = Audio_Manager::get();
-	int sample_count = buf_size / am.sample_size;
-	std::vector<WAVE_32BS> buffer(sample_count, {0, 0});
-	const std::lock_guard<std::mutex> lock(am.mutex);
+	Audio_Manager& am = *(Audio_Manager*)context;
+	auto& buffer = am.stream_buffers[index];
+	if(buffer.size() < (unsigned)am.mix_sample_count)
+		buffer.resize(am.mix_sample_count);
+	std::fill_n(buffer.begin(), am.mix_sample_count, WAVE_32BS{0, 0});
+	am.streams[index]->get_sample(buffer.data(), am.mix_sample_count, 2);
+}
 
-	// Input buffer
-	for(auto stream = am.streams.begin(); stream != am.streams.end();)
+//! Render all streams into the mix buffer.
+/*!
+ *  Each stream is rendered into a separate buffer, using the mixer pool
+ *  if more than one stream is playing. The stream buffers are then summed
+ *  into the mix buffer, with stream gain, bus volume and global volume
+ *  applied as a single 8.8 fixed point factor per channel.
+ *
+ *  The peak levels after gain are published to the status of each stream,
+ *  together with the position that the stream set while rendering.
+ */
+void Audio_Manager::mix_streams(int sample_count)
+{
+	if(mix_buffer.size() < (unsigned)sample_count)
+		mix_buffer.resize(sample_count);
+	std::fill_n(mix_buffer.begin(), sample_count, WAVE_32BS{0, 0});
+	mix_sample_count = sample_count;
+
+	if(stream_buffers.size() < streams.size())
+		stream_buffers.resize(streams.size());
+
+	if(streams.size() > 1 && mixer_pool)
+	{
+		mixer_pool->run(streams.size(), Audio_Manager::render_stream, this);
+	}
+	else
+	{
+		for(unsigned int i = 0; i < streams.size(); i++)
+			render_stream(this, i);
+	}
+
+	for(unsigned int i = 0; i < streams.size(); i++)
+	{
+		const Audio_Stream* s = streams[i].get();
+		int32_t volume = (converted_bus_volume[s->get_bus()] * converted_volume) >> 8;
+		int64_t left = (s->get_left_gain() * volume) >> 8;
+		int64_t right = (s->get_right_gain() * volume) >> 8;
+
+		const WAVE_32BS* in = stream_buffers[i].data();
+		int64_t peak_left = 0;
+		int64_t peak_right = 0;
+		for(int j = 0; j < sample_count; j++)
+		{
+			int64_t l = (in[j].L * left) >> 8;
+			int64_t r = (in[j].R * right) >> 8;
+			mix_buffer[j].L += l;
+			mix_buffer[j].R += r;
+			peak_left = std::max(peak_left, std::abs(l));
+			peak_right = std::max(peak_right, std::abs(r));
+		}
+		streams[i]->publish_status(std::min<int64_t>(peak_left >> 8, 32767), std::min<int64_t>(peak_right >> 8, 32767));
+	}
+
+	for(auto stream = streams.begin(); stream != streams.end();)
 	{
 		Audio_Stream* s = stream->get();
-		s->get_sample(buffer.data(), sample_count, 2);
 		if(s->get_finished())
 		{
-			printf("Removing stream %s\n", typeid(*s).name());
-			s->stop_stream();
-			am.streams.erase(stream);
+			s->publish_status(0, 0);
+			finished_streams.push_back(std::move(*stream));
+			stream = streams.erase(stream);
 		}
 		else
 		{
 			stream++;
 		}
 	}
+}
+
+uint32_t Audio_Manager::callback(void* drv_struct, void* user_param, uint32_t buf_size, void* data)
+{
+	Audio_Manager& am = Audio_Manager::get();
+	int sample_count = buf_size / am.sample_size;
+	const std::lock_guard<std::mutex> lock(am.mutex);
+
+	// Input buffer
+	am.mix_streams(sample_count);
+	const std::vector<WAVE_32BS>& buffer = am.mix_buffer;
 
 	// Output buffer
 	switch(am.sample_size)
@@ -409,10 +535,8 @@ uint32_t Audio_Manager::callback(void* drv_struct, void* user_param, uint32_t bu
 			int16_t* sd = (int16_t*) data;
 			for(int i = 0; i < sample_count; i ++)
 			{
-				int32_t l = buffer[i].L >> 8;
-				int32_t r = buffer[i].R >> 8;
-				*sd++ = clip16((l * am.converted_volume) >> 8);
-				*sd++ = clip16((r * am.converted_volume) >> 8);
+				*sd++ = clip16(buffer[i].L >> 8);
+				*sd++ = clip16(buffer[i].R >> 8);
 			}
 			return sample_count * am.sample_size;
 		}
@@ -6,6 +6,10 @@
 #include <map>
 #include <string>
 #include <mutex>
+#include <atomic>
+
+#include "mixer_pool.h"
+#include "stream_status.h"
 
 #if defined(LOCAL_LIBVGM)
 #include "audio/AudioStream.h"
@@ -19,8 +23,23 @@
 class Audio_Stream
 {
 	public:
+		//! Mixer bus that the stream is routed to.
+		enum Bus
+		{
+			BUS_SONG = 0,
+			BUS_PREVIEW = 1,
+			BUS_COUNT
+		};
+
 		inline Audio_Stream()
 			: finished(false)
+			, bus(BUS_SONG)
+			, gain(1.0f)
+			, pan(0.0f)
+			, left_gain(0x100)
+			, right_gain(0x100)
+			, status(std::make_shared<Stream_Status>())
+			, position(0)
 		{}
 
 		inline virtual ~Audio_Stream()
@@ -34,6 +53,9 @@ class Audio_Stream
 
 		//! called by Audio_Manager during stream update.
 		/*!
+		 *  samples should be added to the output buffer. Streams may be
+		 *  rendered in parallel, so each stream gets its own buffer.
+		 *
 		 *  return zero to indicate that the stream should be stopped.
 		 */
 		virtual int get_sample(WAVE_32BS* output, int count, int channels) = 0;
@@ -52,7 +74,7 @@ class Audio_Stream
 		 */
 		inline void set_finished(bool flag)
 		{
-			finished = true;
+			finished = flag;
 		}
 
 		//! get the "finished" flag status
@@ -65,8 +87,62 @@ class Audio_Stream
 			return finished;
 		}
 
+		inline void set_bus(Bus new_bus) { bus = new_bus; }
+		inline Bus get_bus() const { return bus; }
+
+		//! Set stream gain (1.0 = unity) and balance (-1.0 = left, 1.0 = right).
+		inline void set_gain(float new_gain, float new_pan)
+		{
+			gain = new_gain;
+			pan = new_pan;
+			left_gain = gain * ((pan > 0.0f) ? 1.0f - pan : 1.0f) * 256.0f;
+			right_gain = gain * ((pan < 0.0f) ? 1.0f + pan : 1.0f) * 256.0f;
+		}
+		inline float get_gain() const { return gain; }
+		inline float get_pan() const { return pan; }
+
+		//! Get left and right channel gain in 8.8 fixed point. Used by Audio_Manager.
+		inline int32_t get_left_gain() const { return left_gain; }
+		inline int32_t get_right_gain() const { return right_gain; }
+
+		//! Get the status published by the audio thread.
+		/*!
+		 *  The returned object can be read from any thread, and remains
+		 *  valid after the stream is destroyed.
+		 */
+		inline std::shared_ptr<const Stream_Status> get_status() const { return status; }
+
+		//! Get the playback position set by the stream.
+		/*!
+		 *  Only valid in the thread that calls get_sample().
+		 */
+		inline int64_t get_position() const { return position; }
+
+		//! Publish the position, levels and state. Used by Audio_Manager.
+		inline void publish_status(uint16_t peak_left, uint16_t peak_right)
+		{
+			status->publish({position, peak_left, peak_right,
+				finished ? Stream_Status::FINISHED : Stream_Status::PLAYING});
+		}
+
 	protected:
-		bool finished;
+		//! Set the playback position, in a unit that depends on the stream.
+		/*!
+		 *  Call this from get_sample(). The position is published once the
+		 *  audio buffer has been mixed.
+		 */
+		inline void set_position(int64_t new_position) { position = new_position; }
+
+		std::atomic<bool> finished;
+
+	private:
+		std::atomic<Bus> bus;
+		float gain;
+		float pan;
+		std::atomic<int32_t> left_gain;
+		std::atomic<int32_t> right_gain;
+		std::shared_ptr<Stream_Status> status;
+		int64_t position;
 };
 
 //! Audio manager class
@@ -91,6 +167,13 @@ class Audio_Manager
 		void set_volume(float new_volume);
 		float get_volume() const;
 
+		void set_bus_volume(Audio_Stream::Bus bus, float new_volume);
+		float get_bus_volume(Audio_Stream::Bus bus) const;
+
+		//! Set how far ahead of playback song streams are rendered, in milliseconds. Zero disables buffering.
+		inline void set_buffer_length(unsigned int length_ms) { buffer_length = length_ms; }
+		inline unsigned int get_buffer_length() const { return buffer_length; }
+
 		void set_driver(int new_driver_sig, int new_device_id = -1);
 		inline int get_driver() const { return driver_sig; };
 
@@ -98,6 +181,7 @@ class Audio_Manager
 		inline int get_device() const { return device_id; };
 
 		int add_stream(std::shared_ptr<Audio_Stream> stream);
+		void reap_streams();
 
 		const std::map<int, std::pair<int,std::string>>& get_driver_list() const { return driver_list; }
 		const std::map<int, std::string>& get_device_list() const { return device_list; }
@@ -118,6 +202,9 @@ class Audio_Manager
 
 		static int16_t clip16(int32_t input);
 
+		void mix_streams(int sample_count);
+		static void render_stream(void* context, unsigned int index);
+
 		static uint32_t callback(void* drv_struct, void* user_param, uint32_t buf_size, void* data);
 
 		int driver_sig; // Actual driver signature, -1 if not loaded
@@ -129,7 +216,17 @@ class Audio_Manager
 
 		float volume;
 		int32_t converted_volume;
+		float bus_volume[Audio_Stream::BUS_COUNT];
+		int32_t converted_bus_volume[Audio_Stream::BUS_COUNT];
+		unsigned int buffer_length;
 		std::vector<std::shared_ptr<Audio_Stream>> streams;
+		std::vector<std::shared_ptr<Audio_Stream>> finished_streams; // removed by the audio thread, stopped by reap_streams()
+
+		// mixing buffers, only used by the audio thread
+		std::unique_ptr<Mixer_Pool> mixer_pool;
+		std::vector<WAVE_32BS> mix_buffer;
+		std::vector<std::vector<WAVE_32BS>> stream_buffers;
+		int mix_sample_count;
 
 		void* window_handle;
 		void* driver_handle;
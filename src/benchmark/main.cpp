@@ -0,0 +1,399 @@
+//! Benchmarks for compiling, rendering and exporting songs
+/*!
+ *  Every run uses the same generated MML, so that results can be compared
+ *  between builds. Each benchmark is repeated and the minimum, median and
+ *  mean times are reported, along with a throughput figure where it makes
+ *  sense.
+ *
+ *  Usage: benchmark [--iterations N] [--corpus name] [--output file.json]
+ */
+#include "../song_manager.h"
+#include "../track_info.h"
+#include "../emu_player.h"
+#include "../wave_loader.h"
+#include "../export_analysis.h"
+#include "song.h"
+#include "input.h"
+#include "mml_input.h"
+#include "platform/mdsdrv.h"
+#include "stringf.h"
+
+#include <filesystem>
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+namespace fs = std::filesystem;
+
+struct Corpus
+{
+	std::string name;
+	std::string mml;
+};
+
+struct Result
+{
+	std::string corpus;
+	std::string name;
+	unsigned int iterations;
+	double min_ms;
+	double median_ms;
+	double mean_ms;
+	double rate;			// work units per second at the median time, 0 if not used
+	std::string rate_unit;
+	std::string error;
+};
+
+//! Work done by one iteration of a benchmark, for the throughput figure.
+typedef std::function<double()> Benchmark_Function;
+
+static const uint32_t render_rate = 44100;
+static const unsigned int render_seconds = 10;
+
+static std::string fm_instrument(int id, int alg)
+{
+	return stringf("@%d fm %d 5\n"
+		" 31  10   5   5   2  30   0   1   3   0\n"
+		" 31  12   5   5   2  20   0   2   3   0\n"
+		" 31  14   5   5   2  25   0   1   3   0\n"
+		" 31  10   5   7   2   0   0   1   3   0\n", id, alg);
+}
+
+//! A few bars on two channels.
+static std::string make_small()
+{
+	return fm_instrument(1, 4)
+		+ "@2 psg 15 14 13 12 11 10\n"
+		+ "A t150 @1 o4 l8 cdefgab>c<bagfedc2\n"
+		+ "G @2 o5 l4 c e g e c2\n";
+}
+
+//! Every FM and PSG channel playing a long, varied part.
+static std::string make_large()
+{
+	std::string mml;
+	for(int i = 0; i < 8; i++)
+		mml += fm_instrument(i, i);
+	mml += "@10 psg 15 13 11 9 7 5 3 1\n";
+	const char* notes[] = {"c", "d", "e", "f", "g", "a", "b"};
+	const char* tracks = "ABCDEFGHIJ";
+	for(int t = 0; tracks[t]; t++)
+	{
+		std::string line = stringf("%c t140 %s o%d l16", tracks[t], t < 6 ? stringf("@%d", t).c_str() : "@10", 3 + t % 3);
+		for(int bar = 0; bar < 256; bar++)
+		{
+			for(int n = 0; n < 16; n++)
+			{
+				int value = (bar * 7 + n * 3 + t) % 29;
+				line += (value % 11 == 0) ? "r" : notes[value % 7];
+				if(value % 13 == 0)
+					line += (value & 1) ? ">" : "<";
+			}
+			if(bar % 16 == 15)
+			{
+				mml += line + "\n";
+				line = stringf("%c ", tracks[t]);
+			}
+		}
+	}
+	return mml;
+}
+
+//! Deeply nested subroutines, loops and drum mode macros.
+static std::string make_macro_heavy()
+{
+	std::string mml = fm_instrument(1, 7) + fm_instrument(2, 4);
+	for(int i = 0; i < 32; i++)
+		mml += stringf("*%d @%dc ;D30%c\n", 30 + i, 1 + i % 2, 'a' + i % 26);
+	for(int i = 0; i < 16; i++)
+		mml += stringf("*%d [cde*%d]2 f g\n", 70 + i, i ? 69 + i : 30);
+	const char* tracks = "ABCDEF";
+	for(int t = 0; tracks[t]; t++)
+	{
+		mml += stringf("%c t150 @1 o4 l16 [*85 D30 abcdefgh [ab]4 D0 *%d]16\n", tracks[t], 70 + t);
+		mml += stringf("%c [[*%d c]4 *%d]8\n", tracks[t], 72 + t, 80 + t % 6);
+	}
+	return mml;
+}
+
+//! Many PCM samples played in quick succession.
+/*!
+ *  The samples are written to the directory the song is compiled from.
+ */
+static std::string make_pcm_heavy(const fs::path& directory)
+{
+	std::string mml = fm_instrument(1, 4);
+	const int sample_count = 24;
+	for(int i = 0; i < sample_count; i++)
+	{
+		// Decaying tones of different lengths and pitch
+		std::vector<int16_t> samples(2000 + i * 700);
+		for(size_t s = 0; s < samples.size(); s++)
+			samples[s] = std::sin(s * (0.05 + i * 0.01)) * 20000.0 * (1.0 - (double)s / samples.size());
+		std::string filename = stringf("sample%02d.wav", i);
+		save_wave_file((directory / filename).string(), samples.data(), samples.size(), 17500, 1);
+		mml += stringf("@%d pcm \"%s\"\n", 30 + i, filename.c_str());
+	}
+	mml += "A t150 @1 o3 l8 [c c g c]64\n";
+	std::string line = "F mode1 l16 [";
+	for(int i = 0; i < sample_count; i++)
+		line += stringf("@%d c", 30 + i);
+	mml += line + "]16\n";
+	return mml;
+}
+
+//! Parse MML in the same way as Song_Manager::compile_job.
+static std::shared_ptr<Song> parse_mml(const std::string& mml, const std::string& include_path)
+{
+	auto song = std::make_shared<Song>();
+	song->add_tag("include_path", include_path);
+	MML_Input input = MML_Input(song.get());
+	std::stringstream stream(mml);
+	std::string str;
+	int line = 0;
+	while(std::getline(stream, str))
+		input.read_line(str, line++);
+	return song;
+}
+
+//! Compile with a Song_Manager and wait for the worker to finish.
+static void compile(Song_Manager& manager, const std::string& mml, const std::string& filename)
+{
+	if(manager.compile(mml, filename))
+		throw std::runtime_error("Compiler busy");
+	while(manager.get_compile_in_progress())
+		std::this_thread::yield();
+	if(manager.get_compile_result() != Song_Manager::COMPILE_OK)
+		throw std::runtime_error(manager.get_error_message());
+}
+
+static Result run(const std::string& corpus, const std::string& name, unsigned int iterations,
+	const std::string& rate_unit, const Benchmark_Function& function)
+{
+	Result result = {corpus, name, iterations, 0, 0, 0, 0, rate_unit, ""};
+	std::vector<double> times;
+	double work = 0;
+	try
+	{
+		// One untimed run to warm up caches and the device pool
+		function();
+		for(unsigned int i = 0; i < iterations; i++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			work = function();
+			times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+	}
+	catch(std::exception& e)
+	{
+		result.error = e.what();
+		return result;
+	}
+
+	std::sort(times.begin(), times.end());
+	result.min_ms = times.front();
+	result.median_ms = times[times.size() / 2];
+	double sum = 0;
+	for(double t : times)
+		sum += t;
+	result.mean_ms = sum / times.size();
+	if(rate_unit.size() && result.median_ms > 0)
+		result.rate = work / (result.median_ms / 1000.0);
+	return result;
+}
+
+static std::vector<Result> run_corpus(const Corpus& corpus, const fs::path& directory, unsigned int iterations)
+{
+	std::vector<Result> results;
+	std::string filename = (directory / (corpus.name + ".mml")).string();
+	std::string include_path = directory.string() + "/";
+	std::shared_ptr<Song> song;
+
+	results.push_back(run(corpus.name, "parse", iterations, "lines/s", [&]()
+	{
+		song = parse_mml(corpus.mml, include_path);
+		return (double)std::count(corpus.mml.begin(), corpus.mml.end(), '\n');
+	}));
+	if(!song)
+		return results;
+
+	results.push_back(run(corpus.name, "track_info", iterations, "events/s", [&]()
+	{
+		size_t events = 0;
+		// Subroutine tracks are skipped, as in Song_Manager
+		for(auto&& track : song->get_track_map())
+			if(track.first < 16)
+				events += Track_Info_Generator(*song, track.second).events.size();
+		return (double)events;
+	}));
+
+	Song_Manager manager;
+	results.push_back(run(corpus.name, "compile", iterations, "", [&]()
+	{
+		compile(manager, corpus.mml, filename);
+		return 0.0;
+	}));
+
+	results.push_back(run(corpus.name, "editor_position", iterations, "calls/s", [&]()
+	{
+		int lines = std::count(corpus.mml.begin(), corpus.mml.end(), '\n');
+		int calls = 0;
+		for(int line = 0; line < lines; line++)
+		{
+			for(int column : {0, 8, 40})
+			{
+				manager.set_editor_position({line, column});
+				calls++;
+			}
+		}
+		manager.set_editor_position({-1, -1});
+		return (double)calls;
+	}));
+
+	results.push_back(run(corpus.name, "render", iterations, "samples/s", [&]()
+	{
+		Emu_Player player(song);
+		player.setup_stream(render_rate);
+		std::vector<WAVE_32BS> buffer(512);
+		size_t total = render_rate * render_seconds;
+		for(size_t done = 0; done < total; done += buffer.size())
+		{
+			memset(buffer.data(), 0, buffer.size() * sizeof(WAVE_32BS));
+			player.get_sample(buffer.data(), buffer.size(), 2);
+		}
+		return (double)total;
+	}));
+
+	results.push_back(run(corpus.name, "export", iterations, "", [&]()
+	{
+		MDSDRV_Converter converter(*song);
+		RIFF mds = converter.get_mds();
+		MDSDRV_Linker linker;
+		linker.add_song(mds, corpus.name);
+		Export_Analysis analysis;
+		std::vector<uint8_t> pcm_data = linker.get_pcm_data();
+		size_t seq_size = linker.get_seq_data().size();
+		analysis.add_song(corpus.name, mds.to_bytes(), seq_size, pcm_data.size(), pcm_data);
+		analysis.set_output_size(seq_size, pcm_data.size());
+		linker.get_c_header();
+		return 0.0;
+	}));
+	return results;
+}
+
+static std::string json_string(const std::string& str)
+{
+	std::string out = "\"";
+	for(char c : str)
+	{
+		if(c == '"' || c == '\\')
+			out += '\\';
+		if((unsigned char)c < 0x20)
+			out += stringf("\\u%04x", c);
+		else
+			out += c;
+	}
+	return out + "\"";
+}
+
+static std::string to_json(const std::vector<Result>& results, unsigned int iterations)
+{
+	std::string str = "{\n";
+	str += stringf("\t\"iterations\": %u,\n", iterations);
+#ifdef DEBUG
+	str += "\t\"build\": \"debug\",\n";
+#else
+	str += "\t\"build\": \"release\",\n";
+#endif
+	str += "\t\"results\": [";
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		const Result& r = results[i];
+		str += i ? ",\n" : "\n";
+		str += "\t\t{\"corpus\": " + json_string(r.corpus) + ", \"name\": " + json_string(r.name);
+		if(r.error.size())
+		{
+			str += ", \"error\": " + json_string(r.error) + "}";
+			continue;
+		}
+		str += stringf(", \"min_ms\": %.4f, \"median_ms\": %.4f, \"mean_ms\": %.4f", r.min_ms, r.median_ms, r.mean_ms);
+		if(r.rate_unit.size())
+			str += stringf(", \"rate\": %.1f, \"rate_unit\": ", r.rate) + json_string(r.rate_unit);
+		str += "}";
+	}
+	str += results.size() ? "\n\t]\n}\n" : "]\n}\n";
+	return str;
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int iterations = 5;
+	std::string corpus_name = "";
+	std::string output = "";
+	for(int carg = 1; carg < argc; carg++)
+	{
+		if(!std::strcmp(argv[carg], "--iterations") && (argc > carg + 1))
+			iterations = std::max(1l, strtol(argv[++carg], NULL, 0));
+		else if(!std::strcmp(argv[carg], "--corpus") && (argc > carg + 1))
+			corpus_name = argv[++carg];
+		else if(!std::strcmp(argv[carg], "--output") && (argc > carg + 1))
+			output = argv[++carg];
+		else
+		{
+			fprintf(stderr, "Usage: %s [--iterations N] [--corpus name] [--output file.json]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	fs::path directory = fs::temp_directory_path() / "mmlgui_benchmark";
+	fs::create_directories(directory);
+
+	std::vector<Corpus> corpora = {
+		{"small", make_small()},
+		{"large", make_large()},
+		{"macro_heavy", make_macro_heavy()},
+		{"pcm_heavy", make_pcm_heavy(directory)},
+	};
+
+	std::vector<Result> results;
+	bool failed = false;
+	printf("%-12s %-16s %10s %10s %10s %16s\n", "corpus", "benchmark", "min ms", "median ms", "mean ms", "rate");
+	for(auto&& corpus : corpora)
+	{
+		if(corpus_name.size() && corpus.name != corpus_name)
+			continue;
+		for(auto&& r : run_corpus(corpus, directory, iterations))
+		{
+			if(r.error.size())
+			{
+				printf("%-12s %-16s failed: %s\n", r.corpus.c_str(), r.name.c_str(), r.error.c_str());
+				failed = true;
+			}
+			else
+			{
+				printf("%-12s %-16s %10.3f %10.3f %10.3f %10.0f %s\n", r.corpus.c_str(), r.name.c_str(),
+					r.min_ms, r.median_ms, r.mean_ms, r.rate, r.rate_unit.c_str());
+			}
+			results.push_back(r);
+		}
+	}
+	fs::remove_all(directory);
+
+	if(output.size())
+	{
+		std::ofstream out(output, std::ios::binary);
+		out << to_json(results, iterations);
+		if(!out)
+		{
+			fprintf(stderr, "Failed to write %s\n", output.c_str());
+			return 1;
+		}
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+#include "buffered_stream.h"
+
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+
+//! Number of samples rendered by the producer at a time.
+const int Buffered_Stream::block_size = 256;
+
+//! constructs a Buffered_Stream
+/*!
+ *  \param source the stream to render.
+ *  \param buffer_length_ms how far ahead of playback to render.
+ */
+Buffered_Stream::Buffered_Stream(std::shared_ptr<Audio_Stream> source, unsigned int buffer_length_ms)
+	: Audio_Stream()
+	, source(source)
+	, buffer_length(buffer_length_ms)
+	, ring()
+	, position_ring()
+	, block_offset(0)
+	, render_buffer(block_size)
+	, read_buffer(block_size)
+	, producer_running(false)
+	, source_finished(false)
+	, started(false)
+	, underrun_count(0)
+	, producer_ptr(nullptr)
+{
+}
+
+Buffered_Stream::~Buffered_Stream()
+{
+	stop_producer();
+}
+
+//! Set up the source stream and start the producer thread.
+void Buffered_Stream::setup_stream(uint32_t sample_rate)
+{
+	stop_producer();
+
+	source->setup_stream(sample_rate);
+
+	size_t length = (uint64_t)sample_rate * buffer_length / 1000;
+	ring.resize(std::max<size_t>(length, block_size * 2));
+	position_ring.resize(ring.capacity() / block_size + 1);
+	block_offset = 0;
+	source_finished = false;
+	started = false;
+
+	producer_running = true;
+	producer_ptr = std::make_unique<std::thread>(&Buffered_Stream::producer, this);
+}
+
+//! Copy samples from the ring buffer.
+/*!
+ *  Called from the audio thread.
+ */
+int Buffered_Stream::get_sample(WAVE_32BS* output, int count, int channels)
+{
+	int position = 0;
+	while(position < count)
+	{
+		size_t length = ring.read(read_buffer.data(), std::min<size_t>(count - position, read_buffer.size()));
+		if(!length)
+			break;
+		for(size_t i = 0; i < length; i++)
+		{
+			output[position + i].L += read_buffer[i].L;
+			output[position + i].R += read_buffer[i].R;
+		}
+		position += length;
+		started = true;
+
+		block_offset += length;
+		while(block_offset >= block_size)
+		{
+			int64_t source_position;
+			if(position_ring.read(&source_position, 1))
+				set_position(source_position);
+			block_offset -= block_size;
+		}
+	}
+
+	// wake up the producer so that it can refill the buffer.
+	condition_variable.notify_one();
+
+	if(position < count)
+	{
+		if(source_finished)
+			set_finished(true);
+		else if(started)
+			underrun_count++;
+	}
+	return count;
+}
+
+//! Stop the producer thread and the source stream.
+/*!
+ *  This waits for the producer thread, so it must not be called from the
+ *  audio thread. Audio_Manager::reap_streams() calls it from the UI thread.
+ */
+void Buffered_Stream::stop_stream()
+{
+	stop_producer();
+	source->stop_stream();
+}
+
+//! Get the amount of buffered audio, from 0.0 (empty) to 1.0 (full).
+float Buffered_Stream::get_fill_level() const
+{
+	if(!ring.capacity())
+		return 0.0f;
+	return (float)ring.size() / ring.capacity();
+}
+
+//! Get the number of times that the audio callback ran out of samples.
+unsigned int Buffered_Stream::get_underrun_count() const
+{
+	return underrun_count;
+}
+
+//! Producer thread
+void Buffered_Stream::producer()
+{
+	// Sleep at most a quarter of the buffer length between refills.
+	auto timeout = std::chrono::milliseconds(std::max(buffer_length / 4, 1u));
+
+	while(producer_running)
+	{
+		if(source_finished || ring.space() < (size_t)block_size)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition_variable.wait_for(lock, timeout, [this]() {
+				return !producer_running || (!source_finished && ring.space() >= (size_t)block_size);
+			});
+			continue;
+		}
+
+		std::fill(render_buffer.begin(), render_buffer.end(), WAVE_32BS{0, 0});
+		source->get_sample(render_buffer.data(), block_size, 2);
+
+		// The position is queued first, so that it is available when the
+		// audio thread has read the whole block.
+		int64_t source_position = source->get_position();
+		position_ring.write(&source_position, 1);
+		ring.write(render_buffer.data(), block_size);
+
+		if(source->get_finished())
+			source_finished = true;
+	}
+}
+
+//! Stop the producer thread and wait for it to exit.
+void Buffered_Stream::stop_producer()
+{
+	if(producer_ptr && producer_ptr->joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			producer_running = false;
+		}
+		condition_variable.notify_one();
+		producer_ptr->join();
+	}
+	producer_ptr.reset();
+}
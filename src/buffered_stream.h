@@ -0,0 +1,62 @@
+#ifndef BUFFERED_STREAM_H
+#define BUFFERED_STREAM_H
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+#include "audio_manager.h"
+#include "ring_buffer.h"
+
+//! Render-ahead wrapper for an Audio_Stream
+/*!
+ *  The source stream is rendered by a producer thread into a ring buffer,
+ *  a fixed amount of time ahead of playback. The audio callback only copies
+ *  samples out of the ring buffer, so spikes in emulation time do not cause
+ *  buffer underruns.
+ *
+ *  The position of the source is queued with each block, and set as the
+ *  position of this stream once the block has been played.
+ */
+class Buffered_Stream : public Audio_Stream
+{
+	public:
+		Buffered_Stream(std::shared_ptr<Audio_Stream> source, unsigned int buffer_length_ms);
+		virtual ~Buffered_Stream();
+
+		void setup_stream(uint32_t sample_rate) override;
+		int get_sample(WAVE_32BS* output, int count, int channels) override;
+		void stop_stream() override;
+
+		float get_fill_level() const;
+		unsigned int get_underrun_count() const;
+
+	private:
+		void producer();
+		void stop_producer();
+
+		const static int block_size;
+
+		std::shared_ptr<Audio_Stream> source;
+		unsigned int buffer_length;
+
+		Ring_Buffer<WAVE_32BS> ring;
+		Ring_Buffer<int64_t> position_ring;		// source position after each block
+		int block_offset;						// samples played from the current block, used by audio thread
+		std::vector<WAVE_32BS> render_buffer;	// used by producer thread
+		std::vector<WAVE_32BS> read_buffer;		// used by audio thread
+
+		std::atomic<bool> producer_running;
+		std::atomic<bool> source_finished;
+		std::atomic<bool> started;
+		std::atomic<unsigned int> underrun_count;
+
+		std::mutex mutex;
+		std::condition_variable condition_variable;
+		std::unique_ptr<std::thread> producer_ptr;
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "imgui.h"
 #include "config_window.h"
+#include "audio_manager.h"
 
 //=====================================================================
 Config_Window::Config_Window()
@@ -88,13 +89,20 @@ void Config_Window::show_emu_tab()
 
 void Config_Window::show_mixer_tab()
 {
-	static int global_vol = 100;
-	static int sn_vol = 100;
-	static int ym_vol = 100;
-	ImGui::SliderInt("Global volume", &global_vol, 0, 100);
+	auto& am = Audio_Manager::get();
+
+	int global_vol = am.get_volume() * 100.0f;
+	if(ImGui::SliderInt("Global volume", &global_vol, 0, 100))
+		am.set_volume(global_vol / 100.0f);
 	ImGui::Separator();
-	ImGui::SliderInt("SN76489", &sn_vol, 0, 100);
-	ImGui::SliderInt("YM2612", &ym_vol, 0, 100);
+
+	int song_vol = am.get_bus_volume(Audio_Stream::BUS_SONG) * 100.0f;
+	if(ImGui::SliderInt("Song playback", &song_vol, 0, 100))
+		am.set_bus_volume(Audio_Stream::BUS_SONG, song_vol / 100.0f);
+
+	int preview_vol = am.get_bus_volume(Audio_Stream::BUS_PREVIEW) * 100.0f;
+	if(ImGui::SliderInt("PCM preview", &preview_vol, 0, 100))
+		am.set_bus_volume(Audio_Stream::BUS_PREVIEW, preview_vol / 100.0f);
 }
 
 void Config_Window::show_confirm_buttons()
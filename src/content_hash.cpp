@@ -0,0 +1,60 @@
+#include "content_hash.h"
+
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+
+static const uint64_t fnv_offset_basis = 0xcbf29ce484222325ULL;
+static const uint64_t fnv_prime = 0x100000001b3ULL;
+
+//! constructs an empty Content_Hash
+Content_Hash::Content_Hash()
+	: state(fnv_offset_basis)
+{
+}
+
+//! Add data to the hash.
+void Content_Hash::add(const void* data, size_t length)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	uint64_t hash = state;
+	for(size_t i = 0; i < length; i++)
+		hash = (hash ^ bytes[i]) * fnv_prime;
+	state = hash;
+}
+
+//! Add a string to the hash.
+/*!
+ *  The terminating zero is included, so that "ab" + "c" and "a" + "bc"
+ *  give different hashes.
+ */
+void Content_Hash::add(const std::string& str)
+{
+	add(str.c_str(), str.size() + 1);
+}
+
+//! Add the contents of a file to the hash.
+/*!
+ *  \exception std::runtime_error if the file can't be read.
+ */
+void Content_Hash::add_file(const std::string& filename)
+{
+	std::unique_ptr<FILE, decltype(&fclose)> file(fopen(filename.c_str(), "rb"), &fclose);
+	if(!file)
+		throw std::runtime_error("Failed to open " + filename);
+
+	uint8_t buffer[64 * 1024];
+	size_t length;
+	while((length = fread(buffer, 1, sizeof(buffer), file.get())) > 0)
+		add(buffer, length);
+	if(ferror(file.get()))
+		throw std::runtime_error("Failed to read " + filename);
+}
+
+//! Get the hash as 16 hexadecimal digits.
+std::string Content_Hash::to_string() const
+{
+	char str[17];
+	snprintf(str, sizeof(str), "%016llx", (unsigned long long)state);
+	return str;
+}
@@ -0,0 +1,29 @@
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+//! 64-bit FNV-1a hash for detecting changed files
+/*!
+ *  This is used to key caches on file contents and settings. It is fast
+ *  and has few collisions, but is not a cryptographic hash.
+ */
+class Content_Hash
+{
+	public:
+		Content_Hash();
+
+		void add(const void* data, size_t length);
+		void add(const std::string& str);
+		void add_file(const std::string& filename);
+
+		inline uint64_t get() const { return state; }
+		std::string to_string() const;
+
+	private:
+		uint64_t state;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "directory_scan.h"
+#include "stringf.h"
+
+namespace fs = std::filesystem;
+
+//! Construct a Directory_Scan.
+/*!
+ *  \param extensions File extensions to look for, including the dot. These
+ *                    are compared case insensitively.
+ */
+Directory_Scan::Directory_Scan(const std::vector<std::string>& extensions)
+	: extensions(extensions)
+{
+}
+
+//! Find all matching files in a directory and its subdirectories.
+/*!
+ *  \return true if the directory was scanned, false if the result of the
+ *          previous scan was still valid.
+ *  \exception std::filesystem::filesystem_error if the directory can't be read.
+ */
+bool Directory_Scan::update(const std::string& path)
+{
+	if(is_up_to_date(path))
+		return false;
+	scan(path);
+	return true;
+}
+
+bool Directory_Scan::is_up_to_date(const std::string& path) const
+{
+	if(path != root || directories.empty())
+		return false;
+	std::error_code ec;
+	for(auto&& i : directories)
+	{
+		auto time = fs::last_write_time(i.first, ec);
+		if(ec || time != i.second)
+			return false;
+	}
+	return true;
+}
+
+void Directory_Scan::scan(const std::string& path)
+{
+	root.clear();
+	directories.clear();
+	files.clear();
+
+	// Record the time before walking, so that a change during the scan is
+	// picked up by the next one.
+	directories[path] = fs::last_write_time(path);
+	for(const auto& entry : fs::recursive_directory_iterator(path))
+	{
+		if(entry.is_directory())
+		{
+			directories[entry.path().string()] = entry.last_write_time();
+		}
+		else if(entry.is_regular_file())
+		{
+			std::string ext = entry.path().extension().string();
+			for(auto&& i : extensions)
+			{
+				if(iequal(ext, i))
+				{
+					files.push_back(entry.path().string());
+					break;
+				}
+			}
+		}
+	}
+	root = path;
+}
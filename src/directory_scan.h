@@ -0,0 +1,39 @@
+#ifndef DIRECTORY_SCAN_H
+#define DIRECTORY_SCAN_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <filesystem>
+
+//! Cached recursive search for files by extension
+/*!
+ *  A directory's modification time changes whenever a file or directory
+ *  is added, removed or renamed inside it. After the first scan, update()
+ *  therefore only checks the time of each directory that was found, and
+ *  only walks the tree again if one of them has changed.
+ *
+ *  Changes to the contents of the files themselves are not detected; that
+ *  is up to the caller.
+ */
+class Directory_Scan
+{
+	public:
+		Directory_Scan(const std::vector<std::string>& extensions);
+
+		bool update(const std::string& path);
+
+		//! Get the files found by the last update(), in directory order.
+		inline const std::vector<std::string>& get_files() const { return files; }
+
+	private:
+		bool is_up_to_date(const std::string& path) const;
+		void scan(const std::string& path);
+
+		std::vector<std::string> extensions;
+		std::string root;
+		std::map<std::string, std::filesystem::file_time_type> directories;
+		std::vector<std::string> files;
+};
+
+#endif
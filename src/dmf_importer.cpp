@@ -8,41 +8,73 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <algorithm>
+#include <stdexcept>
 
 #include "dmf_importer.h"
+#include "mapped_file.h"
 #include "stringf.h"
 
 #define MINIZ_HEADER_FILE_ONLY
 #include "miniz.c"
 
+//! Largest decompressed size accepted, to guard against corrupt files.
+static const size_t max_dmf_size = 0x10000000;
+
 Dmf_Importer::Dmf_Importer(const char* filename)
 {
-	if(std::ifstream is{filename, std::ios::binary | std::ios::ate})
+	try
+	{
+		Mapped_File dmfz(filename);
+		if(inflate_data(dmfz.data(), dmfz.size()))
+			parse();
+	}
+	catch(std::exception&)
 	{
-		auto size = is.tellg();
-		std::vector<uint8_t> dmfz(size, '\0');
-		is.seekg(0);
-		if(is.read((char*)&dmfz[0],size))
+		error_output = "File could not be opened\n";
+	}
+}
+
+//! Decompress the module into the data buffer.
+/*!
+ *  The buffer starts at a few times the compressed size and is doubled
+ *  whenever it fills up, so that memory use follows the actual module size.
+ */
+bool Dmf_Importer::inflate_data(const uint8_t* dmfz, size_t size)
+{
+	mz_stream stream = {};
+	stream.next_in = dmfz;
+	stream.avail_in = size;
+	if(mz_inflateInit(&stream) != MZ_OK)
+	{
+		error_output = "File could not be decompressed\n";
+		return false;
+	}
+
+	data.resize(std::max<size_t>(size * 4, 0x10000));
+	int res;
+	do
+	{
+		if(stream.total_out == data.size())
 		{
-			uLong dmfsize = 0x1000000;
-			data.resize(dmfsize, 0);
-
-			int res;
-			res = uncompress((Byte*) data.data(), &dmfsize, (Byte*) dmfz.data(), dmfz.size());
-			if (res != Z_OK)
-			{
-				error_output = "File could not be decompressed\n";
-			}
-			else
-			{
-				parse();
-			}
+			if(data.size() >= max_dmf_size)
+				break;
+			data.resize(data.size() * 2);
 		}
+		stream.next_out = data.data() + stream.total_out;
+		stream.avail_out = data.size() - stream.total_out;
+		res = mz_inflate(&stream, MZ_NO_FLUSH);
 	}
-	else
+	while(res == MZ_OK);
+	data.resize(stream.total_out);
+	mz_inflateEnd(&stream);
+
+	if(res != MZ_STREAM_END)
 	{
-		error_output = "File could not be opened\n";
+		error_output = "File could not be decompressed\n";
+		return false;
 	}
+	return true;
 }
 
 std::string Dmf_Importer::get_error()
@@ -52,40 +84,82 @@ std::string Dmf_Importer::get_error()
 
 std::string Dmf_Importer::get_mml()
 {
-	return mml_output;
+	std::string mml;
+	for(auto&& i : instruments)
+		mml += i.get_mml(i.id);
+	return mml;
 }
 
-static inline uint32_t read_le32(uint8_t* data)
+//! Get the instruments that were found in the module.
+const std::vector<Dmf_Instrument>& Dmf_Importer::get_instruments() const
 {
-	return data[0]|(data[1]<<8)|(data[2]<<16)|(data[3]<<24);
+	return instruments;
 }
 
-static inline std::string read_str(uint8_t* data, uint8_t length)
+//! Get the MML definition of the instrument with the given number.
+std::string Dmf_Instrument::get_mml(int number) const
 {
-	std::string out;
-	for(int i = 0; i < length; i++)
-	{
-		out.push_back(*data++);
-	}
-	return out;
+	return stringf("@%d %s ; %s", number, type.c_str(), name.c_str()) + parameters;
 }
 
-void Dmf_Importer::parse()
+//! Get the next byte.
+uint8_t Dmf_Reader::read_u8()
+{
+	return *read(1);
+}
+
+//! Get the next 32-bit little endian value.
+uint32_t Dmf_Reader::read_le32()
+{
+	const uint8_t* ptr = read(4);
+	return ptr[0]|(ptr[1]<<8)|(ptr[2]<<16)|((uint32_t)ptr[3]<<24);
+}
+
+//! Get a string of the given length.
+std::string Dmf_Reader::read_str(size_t length)
 {
-	uint8_t tmp8;
+	const uint8_t* ptr = read(length);
+	return std::string((const char*)ptr, length);
+}
 
-	uint8_t* dmfptr = data.data();
+//! Get a pointer to the next bytes and skip past them.
+/*!
+ *  \exception std::runtime_error if there are not enough bytes left.
+ */
+const uint8_t* Dmf_Reader::read(size_t length)
+{
+	if(length > size - position)
+		throw std::runtime_error("Unexpected end of file");
+	const uint8_t* ptr = data + position;
+	position += length;
+	return ptr;
+}
 
-	dmfptr += 16; // skip header
+void Dmf_Importer::parse()
+{
+	try
+	{
+		Dmf_Reader reader(data.data(), data.size());
+		parse(reader);
+	}
+	catch(std::exception& e)
+	{
+		error_output = std::string(e.what()) + "\n";
+	}
+}
 
-	uint8_t version = *dmfptr++;
+void Dmf_Importer::parse(Dmf_Reader& reader)
+{
+	reader.skip(16); // skip header
+
+	uint8_t version = reader.read_u8();
 	if(version != 0x18)
 	{
 		error_output = stringf("Incompatible DMF version (found '0x%02x', expected '0x18')\nTry opening and saving the file in Deflemask legacy.",version);
 		return;
 	}
 
-	uint8_t system = *dmfptr++;
+	uint8_t system = reader.read_u8();
 	if((system & 0x3f) != 0x02)
 	{
 		error_output = "Sorry, the DMF must be a GENESIS module.\n";
@@ -97,44 +171,39 @@ void Dmf_Importer::parse()
 		channel_count += 3;
 
 	// Skip song name
-	tmp8 = *dmfptr++;
-	dmfptr += tmp8;
+	reader.skip(reader.read_u8());
 
 	// Skip song author
-	tmp8 = *dmfptr++;
-	dmfptr += tmp8;
+	reader.skip(reader.read_u8());
 
 	// Skip highlight A/B, timebase, frame mode, custom HZ
-	dmfptr += 10;
+	reader.skip(10);
 
-	pattern_rows = read_le32(dmfptr);
-	dmfptr += 4;
+	pattern_rows = reader.read_le32();
 	//printf("Number of pattern rows: %d (%08x)\n", dmf_pattern_rows, dmf_pattern_rows);
 
-	matrix_rows = *dmfptr++;
+	matrix_rows = reader.read_u8();
 	//printf("Number of pattern matrix rows: %d\n", dmf_matrix_rows);
 
 	// Skip pattern matrix rows
-	dmfptr += channel_count * matrix_rows;
+	reader.skip(channel_count * matrix_rows);
 
 	// Now read instruments
-	instrument_count = *dmfptr++;
+	instrument_count = reader.read_u8();
 
 	for(int ins_counter = 0; ins_counter < instrument_count; ins_counter ++)
 	{
-		tmp8 = *dmfptr++;
-		auto name = read_str(dmfptr, tmp8);
-		dmfptr += tmp8;
+		auto name = reader.read_str(reader.read_u8());
 
-		uint8_t type = *dmfptr++;
+		uint8_t type = reader.read_u8();
 
 		if(type == 0)
 		{
-			dmfptr = parse_psg_instrument(dmfptr, ins_counter, name);
+			parse_psg_instrument(reader, ins_counter, name);
 		}
 		else if(type == 1)
 		{
-			dmfptr = parse_fm_instrument(dmfptr, ins_counter, name);
+			parse_fm_instrument(reader, ins_counter, name);
 		}
 		else
 		{
@@ -157,52 +226,58 @@ void Dmf_Importer::parse()
 #define SR ptr[op+10]
 #define SSG (ptr[op+11] | ptr[op+0] * 100)
 
-uint8_t* Dmf_Importer::parse_fm_instrument(uint8_t* ptr, int id, std::string str)
+void Dmf_Importer::parse_fm_instrument(Dmf_Reader& reader, int id, const std::string& str)
 {
 	uint8_t op_table[4] = {4, 28, 16, 40};
 	uint8_t dt_table[7] = {7, 6, 5, 0, 1, 2, 3};
 
-	mml_output += stringf("@%d fm %d %d ; %s\n", id, ALG, FB, str.c_str());
+	const uint8_t* ptr = reader.read(52);
+	for(int opr=0; opr<4; opr++)
+	{
+		if(ptr[op_table[opr]+9] >= sizeof(dt_table))
+			throw std::runtime_error("Invalid detune value in instrument " + str);
+	}
+
+	Dmf_Instrument ins = {id, str, stringf("fm %d %d", ALG, FB), "\n"};
 	for(int opr=0; opr<4; opr++)
 	{
 		uint8_t op = op_table[opr];
-		mml_output += stringf(" %3d %3d %3d %3d %3d %3d %3d %3d %3d %3d \n",
+		ins.parameters += stringf(" %3d %3d %3d %3d %3d %3d %3d %3d %3d %3d \n",
 								AR, DR, SR, RR, SL, TL, KS, ML, DT, SSG);
 	}
-	return ptr + 52;
+	instruments.push_back(ins);
 }
 
-uint8_t* Dmf_Importer::parse_psg_instrument(uint8_t* ptr, int id, std::string str)
+void Dmf_Importer::parse_psg_instrument(Dmf_Reader& reader, int id, const std::string& str)
 {
 	uint8_t size;
 	uint8_t loop;
 
-	size = *ptr++;
+	size = reader.read_u8();
 	if(size)
 	{
-		mml_output += stringf("@%d psg ; %s", id, str.c_str());
-		loop = ptr[size * 4];
+		const uint8_t* ptr = reader.read(size * 4);
+		loop = reader.read_u8();
 
+		Dmf_Instrument ins = {id, str, "psg", ""};
 		for(int i=0; i<size; i++)
 		{
-			mml_output += stringf(  "%s %s%d",
+			ins.parameters += stringf(  "%s %s%d",
 				(i % 16 == 0) ? "\n" : "",
 				(loop == i) ? "| " : "",
 				ptr[i * 4]);
 		}
-		mml_output += "\n";
-		ptr += size * 4 + 1;
+		ins.parameters += "\n";
+		instruments.push_back(ins);
 	}
 
 	for(int i = 0; i < 3; i++)
 	{
-		size = *ptr++;
+		size = reader.read_u8();
 		if(size)
-			ptr += size * 4 + 1;
+			reader.skip(size * 4 + 1);
 		// skip arp macro mode
 		if(i == 0)
-			ptr++;
+			reader.skip(1);
 	}
-
-	return ptr;
 }
@@ -4,6 +4,46 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <cstddef>
+
+//! Bounds checked reader for a DMF module
+/*!
+ *  All reads throw std::runtime_error instead of going past the end of the
+ *  data, so that a truncated or corrupt module gives an error message.
+ */
+class Dmf_Reader
+{
+	public:
+		Dmf_Reader(const uint8_t* data, size_t size)
+			: data(data)
+			, size(size)
+			, position(0)
+		{}
+
+		uint8_t read_u8();
+		uint32_t read_le32();
+		std::string read_str(size_t length);
+		const uint8_t* read(size_t length);
+		inline void skip(size_t length) { read(length); }
+
+		inline size_t get_position() const { return position; }
+
+	private:
+		const uint8_t* data;
+		size_t size;
+		size_t position;
+};
+
+//! An instrument converted to MML
+struct Dmf_Instrument
+{
+	int id;					// instrument number in the module
+	std::string name;
+	std::string type;		// "fm <alg> <fb>" or "psg"
+	std::string parameters;	// the rest of the definition, from the end of the first line
+
+	std::string get_mml(int number) const;
+};
 
 class Dmf_Importer
 {
@@ -12,14 +52,17 @@ class Dmf_Importer
 
 		std::string get_error();
 		std::string get_mml();
+		const std::vector<Dmf_Instrument>& get_instruments() const;
 
 	private:
+		bool inflate_data(const uint8_t* dmfz, size_t size);
 		void parse();
-		uint8_t* parse_fm_instrument(uint8_t* ptr, int id, std::string str);
-		uint8_t* parse_psg_instrument(uint8_t* ptr, int id, std::string str);
+		void parse(Dmf_Reader& reader);
+		void parse_fm_instrument(Dmf_Reader& reader, int id, const std::string& str);
+		void parse_psg_instrument(Dmf_Reader& reader, int id, const std::string& str);
 
 		std::string error_output;
-		std::string mml_output;
+		std::vector<Dmf_Instrument> instruments;
 		std::vector<uint8_t> data;
 
 		uint8_t channel_count;
@@ -0,0 +1,156 @@
+#include "dmf_library.h"
+#include "directory_scan.h"
+#include "content_hash.h"
+#include "parallel_for.h"
+#include "stringf.h"
+
+#include <filesystem>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+//! constructs an empty Dmf_Library
+/*!
+ *  \param thread_count Number of modules to import at once. 0 = one per
+ *                      hardware thread.
+ */
+Dmf_Library::Dmf_Library(unsigned int thread_count)
+	: thread_count(thread_count)
+	, patches()
+	, errors()
+	, file_count(0)
+	, instrument_count(0)
+{
+}
+
+//! Add all DMF modules in a directory and its subdirectories.
+/*!
+ *  Modules are added sorted by path, so that the library is the same each
+ *  time it is built from the same files.
+ *
+ *  \exception std::filesystem::filesystem_error if the directory can't be read.
+ */
+void Dmf_Library::add_directory(const std::string& path)
+{
+	Directory_Scan scan({".dmf"});
+	scan.update(path);
+	std::vector<std::string> files = scan.get_files();
+	std::sort(files.begin(), files.end());
+	add_files(files);
+}
+
+//! Add DMF modules to the library.
+/*!
+ *  Modules that can't be imported are listed in get_errors(), and the
+ *  instruments before the error are not added.
+ */
+void Dmf_Library::add_files(const std::vector<std::string>& files)
+{
+	struct Imported
+	{
+		std::vector<Dmf_Instrument> instruments;
+		std::vector<uint64_t> hashes;
+		std::string error;
+	};
+	std::vector<Imported> imported(files.size());
+
+	parallel_for(files.size(), thread_count, [&](unsigned int index)
+	{
+		Dmf_Importer importer(files[index].c_str());
+		Imported& result = imported[index];
+		result.error = importer.get_error();
+		if(result.error.size())
+			return;
+		result.instruments = importer.get_instruments();
+		for(auto&& i : result.instruments)
+		{
+			// The name is not part of the key
+			Content_Hash hash;
+			hash.add(i.type);
+			hash.add(i.parameters);
+			result.hashes.push_back(hash.get());
+		}
+	});
+
+	// Merge in file order, so that patch numbers don't depend on timing
+	for(size_t f = 0; f < files.size(); f++)
+	{
+		file_count++;
+		Imported& result = imported[f];
+		if(result.error.size())
+		{
+			std::string message = result.error;
+			while(message.size() && message.back() == '\n')
+				message.pop_back();
+			errors.push_back({files[f], message});
+			continue;
+		}
+		for(size_t i = 0; i < result.instruments.size(); i++)
+		{
+			const Dmf_Instrument& ins = result.instruments[i];
+			Source source = {files[f], ins.id, ins.name};
+			instrument_count++;
+
+			std::vector<size_t>& matches = patch_index[result.hashes[i]];
+			auto it = std::find_if(matches.begin(), matches.end(), [&](size_t index)
+			{
+				const Dmf_Instrument& other = patches[index].instrument;
+				return other.type == ins.type && other.parameters == ins.parameters;
+			});
+			if(it != matches.end())
+			{
+				patches[*it].sources.push_back(source);
+			}
+			else
+			{
+				matches.push_back(patches.size());
+				patches.push_back({ins, result.hashes[i], {source}});
+			}
+		}
+	}
+}
+
+//! Get the library as MML.
+/*!
+ *  Patches are numbered from 0 in the order they were first found, and
+ *  named after their first source. A comment above each patch lists
+ *  every module and instrument number that it was found in.
+ */
+std::string Dmf_Library::get_mml() const
+{
+	std::string mml = stringf(";\n; Instrument library from %u DMF file(s)\n; %u instrument(s), %zu unique\n;\n\n",
+		file_count, instrument_count, patches.size());
+	for(size_t i = 0; i < patches.size(); i++)
+	{
+		const Patch& patch = patches[i];
+		for(auto&& source : patch.sources)
+			mml += stringf("; %s @%d %s\n", source.filename.c_str(), source.id, source.name.c_str());
+		mml += patch.instrument.get_mml(i) + "\n";
+	}
+	return mml;
+}
+
+//! Get the mapping from source instruments to library patches.
+/*!
+ *  This is a tab separated table with a header line and one line per
+ *  source instrument: file name, instrument number, instrument name and
+ *  patch number in the library.
+ */
+std::string Dmf_Library::get_mapping() const
+{
+	std::string map = "file\tinstrument\tname\tpatch\n";
+	for(size_t i = 0; i < patches.size(); i++)
+	{
+		for(auto&& source : patches[i].sources)
+			map += stringf("%s\t%d\t%s\t%zu\n", source.filename.c_str(), source.id, source.name.c_str(), i);
+	}
+	return map;
+}
+
+void Dmf_Library::print_summary(FILE* output) const
+{
+	for(auto&& i : errors)
+		fprintf(output, "%s: failed: %s\n", fs::path(i.filename).filename().string().c_str(), i.message.c_str());
+	fprintf(output, "Imported %u of %u files, %u instruments, %zu unique.\n",
+		file_count - (unsigned int)errors.size(), file_count, instrument_count, patches.size());
+}
@@ -0,0 +1,66 @@
+#ifndef DMF_LIBRARY_H
+#define DMF_LIBRARY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <cstdint>
+
+#include "dmf_importer.h"
+
+//! Builds one MML instrument library from a directory of DMF modules
+/*!
+ *  Modules are imported in parallel. Each FM and PSG instrument is keyed
+ *  by a hash of its converted parameters, so the same patch found in
+ *  several modules (or under different names) is only included once.
+ *  Every patch keeps a list of where it was found.
+ */
+class Dmf_Library
+{
+	public:
+		struct Source
+		{
+			std::string filename;
+			int id;					// instrument number in the module
+			std::string name;
+		};
+
+		struct Patch
+		{
+			Dmf_Instrument instrument;
+			uint64_t hash;
+			std::vector<Source> sources;
+		};
+
+		struct File_Error
+		{
+			std::string filename;
+			std::string message;
+		};
+
+		Dmf_Library(unsigned int thread_count = 0);
+
+		void add_directory(const std::string& path);
+		void add_files(const std::vector<std::string>& files);
+
+		inline const std::vector<Patch>& get_patches() const { return patches; }
+		inline const std::vector<File_Error>& get_errors() const { return errors; }
+		inline unsigned int get_file_count() const { return file_count; }
+		inline unsigned int get_instrument_count() const { return instrument_count; }
+
+		std::string get_mml() const;
+		std::string get_mapping() const;
+
+		void print_summary(FILE* output) const;
+
+	private:
+		unsigned int thread_count;
+		std::vector<Patch> patches;
+		std::map<uint64_t, std::vector<size_t>> patch_index;	// hash to patch numbers
+		std::vector<File_Error> errors;
+		unsigned int file_count;
+		unsigned int instrument_count;
+};
+
+#endif
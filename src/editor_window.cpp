@@ -131,6 +131,13 @@ void Editor_Window::display()
 				play_from_cursor();
 			if (ImGui::MenuItem("Stop", "Escape or F8"))
 				stop_song();
+			ImGui::Separator();
+			float gain = song_manager->get_gain() * 100.0f;
+			float pan = song_manager->get_pan() * 100.0f;
+			bool gain_changed = ImGui::SliderFloat("Volume", &gain, 0.0f, 200.0f, "%.0f%%");
+			gain_changed |= ImGui::SliderFloat("Balance", &pan, -100.0f, 100.0f, "%.0f");
+			if (gain_changed)
+				song_manager->set_gain(gain / 100.0f, pan / 100.0f);
 			ImGui::EndMenu();
 		}
 
@@ -791,6 +798,17 @@ void Editor_Window::show_player_controls()
 	if (ImGui::Button("Stop", size))
 		stop_song();
 
+	// Show render-ahead buffer status
+	auto buffered_stream = song_manager->get_buffered_stream();
+	if(buffered_stream != nullptr && !buffered_stream->get_finished() && ImGui::IsItemHovered())
+	{
+		ImGui::BeginTooltip();
+		ImGui::Text("Buffer: %3.0f%% (%d underruns)",
+			buffered_stream->get_fill_level() * 100.0f,
+			buffered_stream->get_underrun_count());
+		ImGui::EndTooltip();
+	}
+
 /*
 	// Handle a progress bar. Just dummy for now
 	float bar_test = width / content;
@@ -830,6 +848,12 @@ std::string Editor_Window::dump_state()
 {
 	std::string str = "filename: " + filename + "\n";
 	str += "modified: " + std::to_string(test_flag(MODIFIED)) + "\n";
+	auto buffered_stream = song_manager->get_buffered_stream();
+	if(buffered_stream != nullptr)
+	{
+		str += "buffer fill: " + std::to_string(buffered_stream->get_fill_level()) + "\n";
+		str += "buffer underruns: " + std::to_string(buffered_stream->get_underrun_count()) + "\n";
+	}
 	str += "contents:\n" + editor.GetText() + "\nend contents\n";
 	return str;
 }
@@ -891,9 +915,13 @@ void Editor_Window::show_track_positions()
 	if(tracks != nullptr)
 		map = *tracks;
 
-	auto player = song_manager->get_player();
-	if(player != nullptr && !player->get_finished())
-		ticks = player->get_driver()->get_player_ticks();
+	auto status = song_manager->get_playback_status();
+	if(status != nullptr)
+	{
+		auto snapshot = status->read();
+		if(snapshot.state == Stream_Status::PLAYING)
+			ticks = snapshot.position;
+	}
 
 	auto song = song_manager->get_song();
 	if(song == nullptr)
@@ -19,6 +19,7 @@
 #include <cstdlib>
 #include <stdexcept>
 #include <algorithm>
+#include <string>
 
 #define DEBUG_PRINT(fmt,...)
 
@@ -29,6 +30,9 @@ Device_Wrapper::Device_Wrapper()
 	: dev_init(false)
 	, resmpl_init(false)
 	, write_type(Device_Wrapper::NONE)
+	, device_id(0xff)
+	, clock(0)
+	, sample_rate(44100)
 	, volume(0x100)
 	, write_a8d8(nullptr)
 {
@@ -97,6 +101,9 @@ void Device_Wrapper::init_sn76489(uint32_t freq, uint8_t lfsr_w, uint16_t lfsr_t
 	sn_cfg.segaPSG = 1; //???
 	sn_cfg.t6w28_tone = NULL;
 
+	device_id = DEVID_SN76496;
+	clock = freq;
+
 	uint8_t status = SndEmu_Start(DEVID_SN76496, (DEV_GEN_CFG*)&sn_cfg, &dev);
 	if(status)
 		throw std::runtime_error("Device_Wrapper::init_sn76489");
@@ -120,6 +127,9 @@ void Device_Wrapper::init_ym2612(uint32_t freq)
 	dev_cfg.clock = freq;
 	dev_cfg.smplRate = 44100;
 
+	device_id = DEVID_YM2612;
+	clock = freq;
+
 	uint8_t status = SndEmu_Start(DEVID_YM2612, (DEV_GEN_CFG*)&dev_cfg, &dev);
 	if(status)
 		throw std::runtime_error("Device_Wrapper::init_ym2612");
@@ -170,6 +180,148 @@ inline void Device_Wrapper::set_mute_mask(uint32_t mask)
 		dev.devDef->SetMuteMask(dev.dataPtr, mask);
 }
 
+//! Reset the device to its power-on state.
+/*!
+ *  The emulator core is kept, but the resampler is released so that no
+ *  samples from the previous song leak into the next one. Call set_rate()
+ *  before using the device again.
+ */
+void Device_Wrapper::reset()
+{
+	if(resmpl_init)
+	{
+		DEBUG_PRINT("deinit resampler\n");
+		Resmpl_Deinit(&resmpl);
+		resmpl_init = false;
+	}
+	if(dev_init)
+	{
+		DEBUG_PRINT("reset emu\n");
+		dev.devDef->Reset(dev.dataPtr);
+		dev.devDef->SetMuteMask(dev.dataPtr, 0);
+	}
+}
+
+//=====================================================================
+
+Device_Pool::Device_Pool()
+	: max_players(8)
+	, idle_devices()
+	, used_devices()
+{
+}
+
+//! get the shared instance of Device_Pool
+std::shared_ptr<Device_Pool> Device_Pool::get()
+{
+	static std::shared_ptr<Device_Pool> instance(new Device_Pool());
+	return instance;
+}
+
+//! Get an initialized device.
+/*!
+ *  An idle device with the same type and clock is reused if one is
+ *  available, otherwise a new emulator core is started.
+ *
+ *  \exception std::runtime_error if the player limit has been reached
+ *             or if the emulator could not be started.
+ */
+std::shared_ptr<Device_Wrapper> Device_Pool::acquire(uint8_t device_id, uint32_t clock, uint16_t volume)
+{
+	Device_Key key = {device_id, clock};
+	std::shared_ptr<Device_Wrapper> device = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(used_devices[key] >= max_players)
+			throw std::runtime_error("Too many concurrent players (limit is " + std::to_string(max_players) + ")");
+
+		auto& idle = idle_devices[key];
+		if(idle.size())
+		{
+			device = idle.back();
+			idle.pop_back();
+		}
+		used_devices[key]++;
+	}
+
+	try
+	{
+		if(!device)
+		{
+			DEBUG_PRINT("pool: new device %02x @ %d Hz\n", device_id, clock);
+			device = std::make_shared<Device_Wrapper>();
+			switch(device_id)
+			{
+				case DEVID_SN76496:
+					device->init_sn76489(clock);
+					break;
+				case DEVID_YM2612:
+					device->init_ym2612(clock);
+					break;
+				default:
+					throw std::runtime_error("Device_Pool::acquire: unsupported device");
+			}
+		}
+		device->set_default_volume(volume);
+	}
+	catch(std::exception&)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		used_devices[key]--;
+		throw;
+	}
+	return device;
+}
+
+//! Reset a device and return it to the pool.
+void Device_Pool::release(std::shared_ptr<Device_Wrapper> device)
+{
+	if(!device)
+		return;
+
+	device->reset();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	Device_Key key = {device->get_device_id(), device->get_clock()};
+	auto it = used_devices.find(key);
+	if(it != used_devices.end() && it->second)
+		it->second--;
+
+	auto& idle = idle_devices[key];
+	if(idle.size() < max_players)
+		idle.push_back(device);
+}
+
+//! Set the maximum number of concurrent players.
+/*!
+ *  This limits the number of devices of each type that can be in use at
+ *  the same time, as well as the number of idle devices kept in the pool.
+ */
+void Device_Pool::set_max_players(unsigned int count)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	max_players = count ? count : 1;
+	for(auto && i : idle_devices)
+	{
+		if(i.second.size() > max_players)
+			i.second.resize(max_players);
+	}
+}
+
+//! Get the maximum number of concurrent players.
+unsigned int Device_Pool::get_max_players() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return max_players;
+}
+
+//! Free all idle devices.
+void Device_Pool::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	idle_devices.clear();
+}
+
 //=====================================================================
 
 Emu_Player::Emu_Player(std::shared_ptr<Song> song, uint32_t start_position)
@@ -178,8 +330,12 @@ Emu_Player::Emu_Player(std::shared_ptr<Song> song, uint32_t start_position)
 	, sample_delta(1)
 	, play_time(0)
 	, play_time2(0)
+	, device_pool(Device_Pool::get())
 	, song(song)
+	, mute_changed(false)
 {
+	for(auto && i : mute_masks)
+		i = 0;
 
 	driver = song->get_platform()->get_driver(1, (VGM_Interface*)this);
 	driver.get()->play_song(*song.get());
@@ -189,6 +345,8 @@ Emu_Player::Emu_Player(std::shared_ptr<Song> song, uint32_t start_position)
 
 Emu_Player::~Emu_Player()
 {
+	for(auto && i : devices)
+		device_pool->release(i.second);
 }
 
 std::shared_ptr<Driver>& Emu_Player::get_driver()
@@ -196,15 +354,31 @@ std::shared_ptr<Driver>& Emu_Player::get_driver()
 	return driver;
 }
 
+//! Post new channel mute masks.
+/*!
+ *  The masks are applied by the renderer at the start of the next call to
+ *  get_sample(), so this is safe to call from any thread. When rendering
+ *  offline, the change takes effect exactly at the next sample rendered.
+ */
 void Emu_Player::set_mute_mask(const std::map<int16_t,uint32_t>& mask_map)
 {
 	for(auto && i : mask_map)
 	{
-		auto dev = devices.find(i.first);
-		if(dev != devices.end())
-		{
-			dev->second.set_mute_mask(i.second);
-		}
+		if(i.first >= 0 && i.first < max_mute_chips)
+			mute_masks[i.first].store(i.second, std::memory_order_relaxed);
+	}
+	mute_changed.store(true, std::memory_order_release);
+}
+
+//! Apply posted mute masks to the devices.
+void Emu_Player::apply_mute_mask()
+{
+	if(!mute_changed.exchange(false, std::memory_order_acquire))
+		return;
+	for(auto && i : devices)
+	{
+		if(i.first >= 0 && i.first < max_mute_chips)
+			i.second->set_mute_mask(mute_masks[i.first].load(std::memory_order_relaxed));
 	}
 }
 
@@ -224,12 +398,13 @@ void Emu_Player::setup_stream(uint32_t sample_rate)
 
 	for(auto it = devices.begin(); it != devices.end(); it++)
 	{
-		it->second.set_rate(sample_rate);
+		it->second->set_rate(sample_rate);
 	}
 }
 
 int Emu_Player::get_sample(WAVE_32BS* output, int count, int channels)
 {
+	apply_mute_mask();
 	try
 	{
 		for(int i = 0; i < count; i++)
@@ -260,9 +435,11 @@ int Emu_Player::get_sample(WAVE_32BS* output, int count, int channels)
 				if(it->second.active)
 				{
 					it->second.counter += it->second.freq;
+					Device_Wrapper* dev = get_device(it->second.chip_id);
 					while(it->second.counter >= sample_rate)
 					{
-						devices[it->second.chip_id].write(
+						if(dev)
+							dev->write(
 								it->second.port,
 								it->second.reg,
 								datablocks[it->second.db_id][it->second.position]);
@@ -279,12 +456,14 @@ int Emu_Player::get_sample(WAVE_32BS* output, int count, int channels)
 			// Get sample from sound chips
 			for(auto && it = devices.begin(); it != devices.end(); it++)
 			{
-				it->second.get_sample(&output[i], 1);
+				it->second->get_sample(&output[i], 1);
 			}
 
 			if(!driver.get()->is_playing())
 				set_finished(true);
 		}
+		// The stream position is the driver tick count
+		set_position(driver.get()->get_player_ticks());
 	}
 	catch(InputError& e)
 	{
@@ -314,15 +493,43 @@ void Emu_Player::handle_error(const char* str)
 // Driver -> Emu_Player
 //=====================================================================
 
+//! Get a device by chip ID, or nullptr if the chip was not initialized.
+inline Device_Wrapper* Emu_Player::get_device(int chip_id)
+{
+	auto it = devices.find(chip_id);
+	if(it != devices.end())
+		return it->second.get();
+	return nullptr;
+}
+
+//! Replace a device with one from the pool.
+void Emu_Player::set_device(int chip_id, uint32_t clock, uint16_t volume)
+{
+	auto it = devices.find(chip_id);
+	if(it != devices.end())
+	{
+		device_pool->release(it->second);
+		devices.erase(it);
+	}
+	devices[chip_id] = device_pool->acquire(chip_id, clock, volume);
+
+	// Devices from the pool are unmuted, so reapply the mask.
+	if(chip_id >= 0 && chip_id < max_mute_chips)
+		devices[chip_id]->set_mute_mask(mute_masks[chip_id].load(std::memory_order_relaxed));
+}
+
 void Emu_Player::write(uint8_t command, uint16_t port, uint16_t reg, uint16_t data)
 {
+	Device_Wrapper* dev;
 	switch(command)
 	{
 		case 0x50:
-			devices[DEVID_SN76496].write(reg, data);
+			if((dev = get_device(DEVID_SN76496)))
+				dev->write(reg, data);
 			break;
 		case 0x52:
-			devices[DEVID_YM2612].write(port, reg, data);
+			if((dev = get_device(DEVID_YM2612)))
+				dev->write(port, reg, data);
 		default:
 			break;
 	}
@@ -363,11 +570,10 @@ void Emu_Player::poke32(uint32_t offset, uint32_t data)
 	switch(offset)
 	{
 		case 0x0c:
-			devices[DEVID_SN76496].set_default_volume(0x80);
-			devices[DEVID_SN76496].init_sn76489(clock);
+			set_device(DEVID_SN76496, clock, 0x80);
 			break;
 		case 0x2c:
-			devices[DEVID_YM2612].init_ym2612(clock);
+			set_device(DEVID_YM2612, clock);
 			break;
 		default:
 			printf("Emu_Player poke %02x = %08x\n", offset, data);
@@ -4,6 +4,9 @@
 #include <memory>
 #include <map>
 #include <vector>
+#include <array>
+#include <mutex>
+#include <atomic>
 
 #if defined(LOCAL_LIBVGM)
 #include "emu/EmuStructs.h"
@@ -25,6 +28,9 @@ class Device_Wrapper
 		Device_Wrapper();
 		virtual ~Device_Wrapper();
 
+		Device_Wrapper(Device_Wrapper const&) = delete;
+		void operator=(Device_Wrapper const&) = delete;
+
 		void set_default_volume(uint16_t vol);
 
 		void set_rate(uint32_t rate);
@@ -42,6 +48,11 @@ class Device_Wrapper
 
 		void set_mute_mask(uint32_t mask);
 
+		void reset();
+
+		inline uint8_t get_device_id() const { return device_id; }
+		inline uint32_t get_clock() const { return clock; }
+
 	private:
 		DEV_INFO dev;
 		RESMPL_STATE resmpl;
@@ -55,11 +66,51 @@ class Device_Wrapper
 			P1A8D8,
 		} write_type;
 
+		uint8_t device_id;
+		uint32_t clock;
 		uint32_t sample_rate;
 		uint16_t volume;
 		DEVFUNC_WRITE_A8D8 write_a8d8;
 };
 
+//! Pool of initialized sound chip emulators
+/*!
+ *  Starting an emulator core allocates and initializes a lot of state, so
+ *  devices are handed back to the pool when a player is done with them and
+ *  only reset when they are reused.
+ *
+ *  The pool is shared by all Emu_Player instances. Players hold a reference
+ *  to it so that devices can be released safely during shutdown.
+ */
+class Device_Pool
+{
+	public:
+		// singleton guard
+		Device_Pool(Device_Pool const&) = delete;
+		void operator=(Device_Pool const&) = delete;
+
+		static std::shared_ptr<Device_Pool> get();
+
+		std::shared_ptr<Device_Wrapper> acquire(uint8_t device_id, uint32_t clock, uint16_t volume = 0x100);
+		void release(std::shared_ptr<Device_Wrapper> device);
+
+		void set_max_players(unsigned int count);
+		unsigned int get_max_players() const;
+
+		void clear();
+
+	private:
+		Device_Pool();
+
+		typedef std::pair<uint8_t, uint32_t> Device_Key; // Device ID, clock
+
+		unsigned int max_players;
+		std::map<Device_Key, std::vector<std::shared_ptr<Device_Wrapper>>> idle_devices;
+		std::map<Device_Key, unsigned int> used_devices;
+
+		mutable std::mutex mutex;
+};
+
 class Emu_Player
 	: private VGM_Interface
 	, public Audio_Stream
@@ -77,6 +128,10 @@ class Emu_Player
 		void stop_stream();
 
 	private:
+		Device_Wrapper* get_device(int chip_id);
+		void set_device(int chip_id, uint32_t clock, uint16_t volume = 0x100);
+		void apply_mute_mask();
+
 		void handle_error(const char* str);
 		void write(uint8_t command, uint16_t port, uint16_t reg, uint16_t data);
 		void dac_setup(uint8_t sid, uint8_t chip_id, uint32_t port, uint32_t reg, uint8_t db_id);
@@ -115,12 +170,19 @@ class Emu_Player
 		float play_time;
 		float play_time2;
 
-		std::map<int, Device_Wrapper> devices;
+		std::shared_ptr<Device_Pool> device_pool;
+		std::map<int, std::shared_ptr<Device_Wrapper>> devices;
 		std::map<int, std::vector<uint8_t>> datablocks;
 		std::map<int, Stream> streams;
 
 		std::shared_ptr<Driver> driver;
 		std::shared_ptr<Song> song;
+
+		// Mute masks are posted by the UI thread and applied by the audio
+		// thread at the start of the next block.
+		const static int max_mute_chips = 0x40;
+		std::array<std::atomic<uint32_t>, max_mute_chips> mute_masks;
+		std::atomic<bool> mute_changed;
 };
 
 #endif
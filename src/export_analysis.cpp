@@ -0,0 +1,274 @@
+#include "export_analysis.h"
+#include "content_hash.h"
+
+#include <map>
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+
+//! Shorter chunks are never counted as PCM, since they could be found in
+//! the sample data by chance.
+const size_t Export_Analysis::min_pcm_chunk_size = 16;
+
+//! constructs an empty Export_Analysis
+Export_Analysis::Export_Analysis()
+	: songs()
+	, output_sequence_bytes(0)
+	, output_pcm_bytes(0)
+	, budget_bytes(0)
+{
+}
+
+//! Add a song to the analysis.
+/*!
+ *  \param mds the MDS file passed to the linker.
+ *  \param sequence_bytes how much the linked sequence data grew with the song.
+ *  \param pcm_bytes how much the linked PCM data grew with the song.
+ *  \param pcm_data the linked PCM data after the song was added.
+ *  \exception std::runtime_error if the MDS data is not a valid RIFF file.
+ */
+void Export_Analysis::add_song(const std::string& name, const std::vector<uint8_t>& mds,
+	size_t sequence_bytes, size_t pcm_bytes, const std::vector<uint8_t>& pcm_data)
+{
+	Song song = {name, mds.size(), sequence_bytes, pcm_bytes, parse_riff(mds.data(), mds.size())};
+	for(auto&& chunk : song.chunks)
+	{
+		if(chunk.size < min_pcm_chunk_size || chunk.size > pcm_data.size())
+			continue;
+		const uint8_t* begin = mds.data() + chunk.offset;
+		const uint8_t* end = begin + chunk.size;
+		auto found = std::search(pcm_data.begin(), pcm_data.end(),
+			std::boyer_moore_horspool_searcher<const uint8_t*>(begin, end));
+		if(found == pcm_data.end())
+			continue;
+
+		chunk.pcm = true;
+		Content_Hash hash;
+		hash.add(begin, chunk.size);
+		chunk.hash = hash.get();
+	}
+	songs.push_back(song);
+}
+
+//! Set the size of the linked sequence and PCM data.
+void Export_Analysis::set_output_size(size_t sequence_bytes, size_t pcm_bytes)
+{
+	output_sequence_bytes = sequence_bytes;
+	output_pcm_bytes = pcm_bytes;
+}
+
+//! Set the space available for the linked data. 0 means no limit.
+void Export_Analysis::set_budget(size_t budget_bytes)
+{
+	this->budget_bytes = budget_bytes;
+}
+
+//! Get the size of PCM chunks that are identical to one in an earlier song.
+/*!
+ *  This is how much the PCM data would be larger if every song kept its
+ *  own copy of its samples.
+ */
+size_t Export_Analysis::get_shared_pcm_bytes() const
+{
+	std::map<std::pair<uint64_t, size_t>, const Song*> first_use;
+	size_t shared = 0;
+	for(auto&& song : songs)
+	{
+		for(auto&& chunk : song.chunks)
+		{
+			if(!chunk.pcm)
+				continue;
+			auto result = first_use.emplace(std::make_pair(chunk.hash, chunk.size), &song);
+			if(!result.second && result.first->second != &song)
+				shared += chunk.size;
+		}
+	}
+	return shared;
+}
+
+//! Get the space left in the budget. Negative if the budget is exceeded.
+long long Export_Analysis::get_remaining_bytes() const
+{
+	return (long long)budget_bytes - (long long)(output_sequence_bytes + output_pcm_bytes);
+}
+
+static uint32_t read_le32(const uint8_t* data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void parse_chunks(const uint8_t* data, size_t begin, size_t end, const std::string& parent,
+	std::vector<Export_Analysis::Chunk>& chunks)
+{
+	size_t pos = begin;
+	while(pos + 8 <= end)
+	{
+		std::string id((const char*)data + pos, 4);
+		size_t size = read_le32(data + pos + 4);
+		size_t start = pos + 8;
+		if(size > end - start)
+			throw std::runtime_error("Chunk '" + id + "' is truncated");
+
+		if((id == "LIST" || id == "RIFF") && size >= 4)
+		{
+			std::string type((const char*)data + start, 4);
+			parse_chunks(data, start + 4, start + size, parent + type + "/", chunks);
+		}
+		else
+		{
+			chunks.push_back({parent + id, start, size, 0, false});
+		}
+		// Chunks are padded to an even length
+		pos = start + size + (size & 1);
+	}
+}
+
+//! Find the data chunks of a RIFF file.
+/*!
+ *  LIST chunks are searched recursively, and the path of each chunk found
+ *  includes the list types. For example, a chunk "abcd" inside a list of
+ *  type "list" in a RIFF file of type "form" has the path "form/list/abcd".
+ *
+ *  \exception std::runtime_error if the data is not a RIFF file or a
+ *             chunk extends past the end of its parent.
+ */
+std::vector<Export_Analysis::Chunk> Export_Analysis::parse_riff(const uint8_t* data, size_t length)
+{
+	if(length < 12 || std::string((const char*)data, 4) != "RIFF")
+		throw std::runtime_error("Not a RIFF file");
+	std::vector<Chunk> chunks;
+	parse_chunks(data, 0, length, "", chunks);
+	return chunks;
+}
+
+//! Get a short summary for the export log.
+std::string Export_Analysis::get_summary() const
+{
+	std::string str;
+	char line[256];
+	for(auto&& song : songs)
+	{
+		snprintf(line, sizeof(line), "  %-24s %8zu seq %8zu pcm\n",
+			song.name.c_str(), song.sequence_bytes, song.pcm_bytes);
+		str += line;
+	}
+	snprintf(line, sizeof(line), "Linked: %zu sequence + %zu PCM = %zu bytes\n",
+		output_sequence_bytes, output_pcm_bytes, output_sequence_bytes + output_pcm_bytes);
+	str += line;
+	size_t shared = get_shared_pcm_bytes();
+	if(shared)
+	{
+		snprintf(line, sizeof(line), "PCM used by more than one song: %zu bytes\n", shared);
+		str += line;
+	}
+	if(budget_bytes)
+	{
+		long long remaining = get_remaining_bytes();
+		if(remaining < 0)
+			snprintf(line, sizeof(line), "Over budget by %lld bytes!\n", -remaining);
+		else
+			snprintf(line, sizeof(line), "Remaining budget: %lld bytes (%.1f%%)\n",
+				remaining, 100.0 * remaining / budget_bytes);
+		str += line;
+	}
+	return str;
+}
+
+static std::string json_string(const std::string& str)
+{
+	std::string out = "\"";
+	for(char c : str)
+	{
+		if(c == '"' || c == '\\')
+		{
+			out += '\\';
+			out += c;
+		}
+		else if((unsigned char)c < 0x20)
+		{
+			char escape[8];
+			snprintf(escape, sizeof(escape), "\\u%04x", c);
+			out += escape;
+		}
+		else
+		{
+			out += c;
+		}
+	}
+	return out + "\"";
+}
+
+//! Get the analysis as a JSON document.
+/*!
+ *  Each PCM chunk lists the other songs that contain the same data, so
+ *  that shared samples can be found without comparing hashes.
+ */
+std::string Export_Analysis::to_json() const
+{
+	std::map<std::pair<uint64_t, size_t>, std::vector<const Song*>> users;
+	for(auto&& song : songs)
+		for(auto&& chunk : song.chunks)
+			if(chunk.pcm)
+				users[std::make_pair(chunk.hash, chunk.size)].push_back(&song);
+
+	std::string str = "{\n\t\"songs\": [";
+	for(size_t i = 0; i < songs.size(); i++)
+	{
+		const Song& song = songs[i];
+		str += i ? ",\n" : "\n";
+		str += "\t\t{\n";
+		str += "\t\t\t\"name\": " + json_string(song.name) + ",\n";
+		str += "\t\t\t\"mds_bytes\": " + std::to_string(song.mds_bytes) + ",\n";
+		str += "\t\t\t\"sequence_bytes\": " + std::to_string(song.sequence_bytes) + ",\n";
+		str += "\t\t\t\"pcm_bytes\": " + std::to_string(song.pcm_bytes) + ",\n";
+		str += "\t\t\t\"chunks\": [";
+		for(size_t j = 0; j < song.chunks.size(); j++)
+		{
+			const Chunk& chunk = song.chunks[j];
+			str += j ? ",\n" : "\n";
+			str += "\t\t\t\t{\"path\": " + json_string(chunk.path);
+			str += ", \"bytes\": " + std::to_string(chunk.size);
+			if(chunk.pcm)
+			{
+				char hash[17];
+				snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)chunk.hash);
+				str += ", \"pcm\": true, \"hash\": \"" + std::string(hash) + "\", \"shared_with\": [";
+				bool first = true;
+				for(const Song* other : users[std::make_pair(chunk.hash, chunk.size)])
+				{
+					if(other == &song)
+						continue;
+					str += (first ? "" : ", ") + json_string(other->name);
+					first = false;
+				}
+				str += "]";
+			}
+			str += "}";
+		}
+		str += song.chunks.size() ? "\n\t\t\t]\n" : "]\n";
+		str += "\t\t}";
+	}
+	str += songs.size() ? "\n\t],\n" : "],\n";
+
+	str += "\t\"output\": {\n";
+	str += "\t\t\"sequence_bytes\": " + std::to_string(output_sequence_bytes) + ",\n";
+	str += "\t\t\"pcm_bytes\": " + std::to_string(output_pcm_bytes) + ",\n";
+	str += "\t\t\"shared_pcm_bytes\": " + std::to_string(get_shared_pcm_bytes()) + ",\n";
+	str += "\t\t\"total_bytes\": " + std::to_string(output_sequence_bytes + output_pcm_bytes) + "\n";
+	str += "\t},\n";
+
+	str += "\t\"budget\": {\n";
+	if(budget_bytes)
+	{
+		str += "\t\t\"bytes\": " + std::to_string(budget_bytes) + ",\n";
+		str += "\t\t\"remaining_bytes\": " + std::to_string(get_remaining_bytes()) + "\n";
+	}
+	else
+	{
+		str += "\t\t\"bytes\": null,\n";
+		str += "\t\t\"remaining_bytes\": null\n";
+	}
+	str += "\t}\n}\n";
+	return str;
+}
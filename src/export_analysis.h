@@ -0,0 +1,72 @@
+#ifndef EXPORT_ANALYSIS_H
+#define EXPORT_ANALYSIS_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//! Size breakdown of an mdslink export
+/*!
+ *  Each song is added as the MDS bytes that are passed to the linker,
+ *  together with how much the linked sequence and PCM data grew when the
+ *  song was added. The sizes reported per song are the linker's own
+ *  figures.
+ *
+ *  The RIFF structure is walked without copying any chunk data. A data
+ *  chunk whose contents appear in the linked PCM data holds samples; chunk
+ *  IDs are not used to tell. Sample chunks are hashed, so that
+ *  samples used by several songs can be found.
+ *
+ *  The sizes of the linked output files and the ROM budget are set
+ *  separately. The result can be written as JSON for other tools, or as a
+ *  short summary for the export log.
+ */
+class Export_Analysis
+{
+	public:
+		//! A data chunk of an MDS file.
+		struct Chunk
+		{
+			std::string path;	// chunk IDs from the top level, separated by '/'
+			size_t offset;		// offset of the data in the MDS file
+			size_t size;
+			uint64_t hash;		// only set for PCM chunks
+			bool pcm;			// contents found in the linked PCM data
+		};
+
+		struct Song
+		{
+			std::string name;
+			size_t mds_bytes;
+			size_t sequence_bytes;
+			size_t pcm_bytes;
+			std::vector<Chunk> chunks;
+		};
+
+		Export_Analysis();
+
+		void add_song(const std::string& name, const std::vector<uint8_t>& mds,
+			size_t sequence_bytes, size_t pcm_bytes, const std::vector<uint8_t>& pcm_data);
+		void set_output_size(size_t sequence_bytes, size_t pcm_bytes);
+		void set_budget(size_t budget_bytes);
+
+		inline const std::vector<Song>& get_songs() const { return songs; }
+		size_t get_shared_pcm_bytes() const;
+		long long get_remaining_bytes() const;
+
+		std::string get_summary() const;
+		std::string to_json() const;
+
+		static std::vector<Chunk> parse_riff(const uint8_t* data, size_t length);
+
+	private:
+		const static size_t min_pcm_chunk_size;
+
+		std::vector<Song> songs;
+		size_t output_sequence_bytes;
+		size_t output_pcm_bytes;
+		size_t budget_bytes;	// 0 if there is no budget
+};
+
+#endif
@@ -0,0 +1,197 @@
+#include "export_cache.h"
+#include "content_hash.h"
+#include "output_file.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+#ifndef CONVERTER_VERSION
+#define CONVERTER_VERSION ""
+#endif
+
+//! Increase this to invalidate all cache entries if the song format changes.
+/*!
+ *  The ctrmml and MDSDRV revisions are added by the build, so that entries
+ *  made by another converter are not used.
+ */
+static const char* cache_version = "mdslink cache 2" CONVERTER_VERSION;
+
+static const char* cache_extension = ".mds";
+
+//! constructs an Export_Cache
+/*!
+ *  The directory is created when the first entry is stored.
+ */
+Export_Cache::Export_Cache(const std::string& directory)
+	: directory(directory)
+	, used_keys()
+	, hit_count(0)
+	, miss_count(0)
+{
+}
+
+//! Read a text file. Returns an empty string if it can't be read.
+static std::string read_text(const fs::path& path)
+{
+	std::ifstream in(path, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+//! Find the files that a song refers to.
+/*!
+ *  MML refers to other files with quoted file names, for example PCM
+ *  samples. Every quoted string that names an existing file, relative to
+ *  the song, is counted as a dependency. Referenced MML files are searched
+ *  as well.
+ *
+ *  \return the paths of the dependencies, sorted and without duplicates.
+ */
+std::vector<std::string> Export_Cache::find_dependencies(const std::string& filename)
+{
+	std::set<std::string> found;
+	std::vector<fs::path> queue = {fs::path(filename)};
+	while(queue.size())
+	{
+		fs::path source = queue.back();
+		queue.pop_back();
+
+		std::string text = read_text(source);
+		size_t position = 0;
+		while((position = text.find('"', position)) != std::string::npos)
+		{
+			size_t end = text.find_first_of("\"\n", position + 1);
+			if(end == std::string::npos)
+				break;
+			if(text[end] == '\n')
+			{
+				position = end;
+				continue;
+			}
+
+			std::string name = text.substr(position + 1, end - position - 1);
+			position = end + 1;
+			if(name.empty())
+				continue;
+
+			std::error_code ec;
+			fs::path path = source.parent_path() / name;
+			if(!fs::is_regular_file(path, ec))
+				continue;
+			std::string key = path.lexically_normal().string();
+			if(!found.insert(key).second)
+				continue;
+
+			std::string ext = path.extension().string();
+			std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+			if(ext == ".mml")
+				queue.push_back(path);
+		}
+	}
+	return std::vector<std::string>(found.begin(), found.end());
+}
+
+//! Get the cache key of a song.
+/*!
+ *  \exception std::runtime_error if the song or a dependency can't be read.
+ */
+std::string Export_Cache::get_key(const std::string& filename) const
+{
+	Content_Hash hash;
+	hash.add(std::string(cache_version));
+	hash.add_file(filename);
+	for(auto && i : find_dependencies(filename))
+	{
+		// The name is included, since renaming a sample changes the song.
+		hash.add(fs::path(i).lexically_relative(fs::path(filename).parent_path()).generic_string());
+		hash.add_file(i);
+	}
+	return hash.to_string();
+}
+
+std::string Export_Cache::get_path(const std::string& key) const
+{
+	return (fs::path(directory) / (key + cache_extension)).string();
+}
+
+//! Load an entry.
+/*!
+ *  \return false if the entry does not exist.
+ */
+bool Export_Cache::load(const std::string& key, std::vector<uint8_t>& data)
+{
+	std::ifstream in(get_path(key), std::ios::binary);
+	if(in)
+	{
+		data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		if(!in.bad() && data.size())
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			used_keys.insert(key);
+			hit_count++;
+			return true;
+		}
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	miss_count++;
+	return false;
+}
+
+//! Store an entry.
+/*!
+ *  Failing to write the entry is not an error, the song is just converted
+ *  again next time.
+ */
+void Export_Cache::store(const std::string& key, const std::vector<uint8_t>& data)
+{
+	std::error_code ec;
+	fs::create_directories(directory, ec);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		used_keys.insert(key);
+	}
+
+	// An interrupted export does not leave a truncated entry, since the
+	// file is only replaced once it is complete.
+	try
+	{
+		Output_File out(get_path(key));
+		out.write(data.data(), data.size());
+		out.commit();
+	}
+	catch(std::exception& e)
+	{
+	}
+}
+
+unsigned int Export_Cache::get_hit_count()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return hit_count;
+}
+
+unsigned int Export_Cache::get_miss_count()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return miss_count;
+}
+
+//! Remove all entries that were not loaded or stored since construction.
+void Export_Cache::prune()
+{
+	std::error_code ec;
+	if(!fs::is_directory(directory, ec))
+		return;
+	std::vector<fs::path> unused;
+	for(auto && entry : fs::directory_iterator(directory, ec))
+	{
+		fs::path path = entry.path();
+		if(path.extension() == cache_extension && !used_keys.count(path.stem().string()))
+			unused.push_back(path);
+	}
+	for(auto && i : unused)
+		fs::remove(i, ec);
+}
@@ -0,0 +1,47 @@
+#ifndef EXPORT_CACHE_H
+#define EXPORT_CACHE_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <cstdint>
+
+//! Persistent cache of converted songs for the mdslink export
+/*!
+ *  Each entry is a file in the cache directory, named after a hash of the
+ *  song source and every file that it refers to (samples and included
+ *  files). A changed file therefore gives a new key, and old entries that
+ *  are no longer used are removed by prune().
+ *
+ *  The cache only stores bytes, it does not know about the MDS format.
+ *  Entries for different keys can be loaded and stored from several
+ *  threads at once.
+ */
+class Export_Cache
+{
+	public:
+		Export_Cache(const std::string& directory);
+
+		std::string get_key(const std::string& filename) const;
+
+		bool load(const std::string& key, std::vector<uint8_t>& data);
+		void store(const std::string& key, const std::vector<uint8_t>& data);
+		void prune();
+
+		unsigned int get_hit_count();
+		unsigned int get_miss_count();
+
+		static std::vector<std::string> find_dependencies(const std::string& filename);
+
+	private:
+		std::string get_path(const std::string& key) const;
+
+		std::string directory;
+		std::mutex mutex;
+		std::set<std::string> used_keys;
+		unsigned int hit_count;
+		unsigned int miss_count;
+};
+
+#endif
@@ -5,6 +5,10 @@
 #include "mml_input.h"
 #include "riff.h"
 #include "stringf.h"
+#include "export_cache.h"
+#include "parallel_for.h"
+#include "output_file.h"
+#include "export_analysis.h"
 #include <filesystem>
 #include <iostream>
 #include <fstream>
@@ -13,7 +17,11 @@
 
 namespace fs = std::filesystem;
 
-Export_Window::Export_Window() : Window(), fs(true, false, true)
+Export_Window::Export_Window()
+	: Window()
+	, bgm_scan({".mml", ".mds"})
+	, sfx_scan({".mml", ".mds"})
+	, fs(true, false, true)
 {
 	type = WT_EXPORT;
 	std::string cwd = fs::current_path().string();
@@ -23,10 +31,26 @@ Export_Window::Export_Window() : Window(), fs(true, false, true)
 	strncpy(seq_filename, "mdsseq.bin", sizeof(seq_filename) - 1);
 	strncpy(pcm_filename, "mdspcm.bin", sizeof(pcm_filename) - 1);
 	strncpy(header_filename, "mdsseq.h", sizeof(header_filename) - 1);
+	strncpy(analysis_filename, "mdslink_analysis.json", sizeof(analysis_filename) - 1);
+	rom_budget = 4096;
 	status_message = "Ready";
 	browse_bgm = false;
 	browse_sfx = false;
 	browse_output = false;
+	use_cache = true;
+	export_running = false;
+	export_cancelled = false;
+	progress_done = 0;
+	progress_total = 0;
+}
+
+Export_Window::~Export_Window()
+{
+	// Songs that are being converted can't be interrupted, so this may
+	// take a moment.
+	cancel_export();
+	if (worker_ptr && worker_ptr->joinable())
+		worker_ptr->join();
 }
 
 void Export_Window::display()
@@ -96,17 +120,46 @@ void Export_Window::display()
 		ImGui::InputText("Sequence Filename", seq_filename, sizeof(seq_filename));
 		ImGui::InputText("PCM Filename", pcm_filename, sizeof(pcm_filename));
 		ImGui::InputText("Header Filename", header_filename, sizeof(header_filename));
+		ImGui::InputText("Analysis Filename", analysis_filename, sizeof(analysis_filename));
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Size of each song and sample as JSON. Leave empty to skip.");
+		ImGui::InputInt("ROM Budget (KiB)", &rom_budget, 64, 1024);
+		if (rom_budget < 0)
+			rom_budget = 0;
 		ImGui::Separator();
 		
-		if (ImGui::Button("Export"))
+		if (export_running)
 		{
-			run_export();
+			if (ImGui::Button(export_cancelled ? "Cancelling..." : "Cancel"))
+				cancel_export();
+			ImGui::SameLine();
+			unsigned int total = progress_total;
+			float progress = total ? (float)progress_done / total : 0.0f;
+			std::string overlay = std::to_string(progress_done) + "/" + std::to_string(total);
+			ImGui::ProgressBar(progress, ImVec2(-1, 0), overlay.c_str());
+		}
+		else
+		{
+			if (ImGui::Button("Export"))
+			{
+				start_export();
+			}
+			ImGui::SameLine();
+			ImGui::Checkbox("Reuse unchanged songs", &use_cache);
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("Songs are only converted again if the MML or a file it refers to has changed.");
 		}
 		
 		ImGui::Separator();
 		ImGui::Text("Output:");
 		ImGui::BeginChild("export_output", ImVec2(0, -ImGui::GetFrameHeightWithSpacing()), false, ImGuiWindowFlags_HorizontalScrollbar);
-		ImGui::TextUnformatted(status_message.c_str());
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			ImGui::TextUnformatted(status_message.c_str());
+		}
+		// Follow the log while exporting
+		if (export_running && ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
+			ImGui::SetScrollHereY(1.0f);
 		ImGui::EndChild();
 	}
 	ImGui::End();
@@ -122,140 +175,268 @@ static Song convert_file(const std::string& filename, std::string& log_output)
 	return song;
 }
 
+//! Load or convert a song for the linker.
+/*!
+ *  MML files are looked up in the cache first, if one is given. This is
+ *  called from worker threads.
+ *
+ *  \exception std::exception if the file can't be read or converted.
+ */
+static RIFF convert_song(const std::string& file, Export_Cache* cache, bool& cached)
+{
+	cached = false;
+	std::string ext = fs::path(file).extension().string();
+	if (iequal(ext, ".mds")) {
+		// RIFF can only be built from an owned vector, so a memory map would
+		// still have to be copied. Read straight into that vector instead.
+		std::ifstream in(file, std::ios::binary | std::ios::ate);
+		if (!in)
+			throw std::runtime_error("Failed to open " + file);
+		auto size = in.tellg();
+		std::vector<uint8_t> data(size);
+		in.seekg(0);
+		if (!in.read((char*)data.data(), size))
+			throw std::runtime_error("Failed to read " + file);
+		return RIFF(std::move(data));
+	}
+
+	// MML
+	std::string key;
+	std::vector<uint8_t> data;
+	if (cache) {
+		key = cache->get_key(file);
+		if (cache->load(key, data)) {
+			cached = true;
+			return RIFF(std::move(data));
+		}
+	}
+	std::string log;
+	Song song = convert_file(file, log);
+	MDSDRV_Converter converter(song);
+	RIFF mds = converter.get_mds();
+	if (cache)
+		cache->store(key, mds.to_bytes());
+	return mds;
+}
+
+//! Write an output file, unless it already has the same contents.
+/*!
+ *  The data is written to a temporary file, which then replaces the
+ *  output file.
+ *
+ *  \return a line for the log.
+ */
+static std::string write_output(const fs::path& path, const void* data, size_t size)
+{
+	Output_File out(path.string());
+	out.write(data, size);
+	if (out.commit())
+		return "  Wrote " + std::to_string(size) + " bytes\n";
+	else
+		return "  Unchanged (" + std::to_string(size) + " bytes)\n";
+}
+
+//! Thrown by the export thread when the export is cancelled.
+struct Export_Cancelled {};
+
 // Helper to match string ending
 static bool ends_with(const std::string& str, const std::string& suffix) {
     if (str.length() < suffix.length()) return false;
     return str.compare(str.length() - suffix.length(), suffix.length(), suffix) == 0;
 }
 
-void Export_Window::run_export()
+//! Start the export in a background thread.
+void Export_Window::start_export()
+{
+	if (export_running)
+		return;
+	if (worker_ptr && worker_ptr->joinable())
+		worker_ptr->join();
+
+	// Copy the settings, since the text fields can be edited during export
+	Export_Settings settings = {bgm_path, sfx_path, output_path, seq_filename, pcm_filename, header_filename,
+		analysis_filename, (size_t)rom_budget * 1024, use_cache};
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		status_message = "Exporting...\n";
+	}
+	progress_done = 0;
+	progress_total = 0;
+	export_cancelled = false;
+	export_running = true;
+	worker_ptr = std::make_unique<std::thread>(&Export_Window::run_export, this, settings);
+}
+
+//! Request the export to stop. Songs that are being converted are finished first.
+void Export_Window::cancel_export()
+{
+	export_cancelled = true;
+}
+
+//! Add text to the output log. Called from the export thread.
+void Export_Window::append_log(const std::string& text)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	status_message += text;
+}
+
+//! Export thread
+void Export_Window::run_export(Export_Settings settings)
 {
-	status_message = "Exporting...";
 	std::vector<std::string> input_files;
 	
 	try {
 		// Search BGM directory
-		if (fs::exists(bgm_path) && fs::is_directory(bgm_path)) {
-			for (const auto& entry : fs::recursive_directory_iterator(bgm_path)) {
-				if (entry.is_regular_file()) {
-					std::string path = entry.path().string();
-					std::string ext = entry.path().extension().string();
-					// Check for .mml or .mds extension (case insensitive)
-					if (iequal(ext, ".mml") || iequal(ext, ".mds")) {
-						input_files.push_back(path);
-					}
-				}
-			}
-		} else if (strlen(bgm_path) > 0) {
-			status_message = "Invalid BGM directory: " + std::string(bgm_path);
-			return;
+		if (fs::exists(settings.bgm_path) && fs::is_directory(settings.bgm_path)) {
+			bgm_scan.update(settings.bgm_path);
+			input_files = bgm_scan.get_files();
+		} else if (settings.bgm_path.size() > 0) {
+			throw std::runtime_error("Invalid BGM directory: " + settings.bgm_path);
 		}
 
 		// Search SFX directory
-		if (fs::exists(sfx_path) && fs::is_directory(sfx_path)) {
-			for (const auto& entry : fs::recursive_directory_iterator(sfx_path)) {
-				if (entry.is_regular_file()) {
-					std::string path = entry.path().string();
-					std::string ext = entry.path().extension().string();
-					// Check for .mml or .mds extension (case insensitive)
-					if (iequal(ext, ".mml") || iequal(ext, ".mds")) {
-						input_files.push_back(path);
-					}
-				}
-			}
-		} else if (strlen(sfx_path) > 0) {
-			status_message = "Invalid SFX directory: " + std::string(sfx_path);
-			return;
+		if (fs::exists(settings.sfx_path) && fs::is_directory(settings.sfx_path)) {
+			sfx_scan.update(settings.sfx_path);
+			input_files.insert(input_files.end(), sfx_scan.get_files().begin(), sfx_scan.get_files().end());
+		} else if (settings.sfx_path.size() > 0) {
+			throw std::runtime_error("Invalid SFX directory: " + settings.sfx_path);
 		}
 		
 		if (input_files.empty()) {
-			status_message = "No .mml or .mds files found in BGM or SFX directories.";
-			return;
+			throw std::runtime_error("No .mml or .mds files found in BGM or SFX directories.");
 		}
 
 		MDSDRV_Linker linker;
-		std::string log;
-		log = "Processing " + std::to_string(input_files.size()) + " file(s)...\n\n";
+		progress_total = input_files.size();
+		append_log("Processing " + std::to_string(input_files.size()) + " file(s)...\n\n");
+
+		// Converted songs are cached by a hash of the MML and the files it refers to
+		Export_Cache cache((fs::path(settings.output_path) / ".mdslink_cache").string());
 
+		// Songs are converted in parallel, then added to the linker in the
+		// original order so that the output does not depend on timing.
+		struct Converted_Song {
+			RIFF mds;
+			bool cached;
+			std::string error;
+		};
+		std::vector<Converted_Song> songs(input_files.size(), Converted_Song{RIFF(0), false, ""});
+		parallel_for(input_files.size(), 0, [&](unsigned int i) {
+			if (export_cancelled)
+				return;
+			try {
+				songs[i].mds = convert_song(input_files[i], settings.use_cache ? &cache : nullptr, songs[i].cached);
+			} catch (const std::exception& e) {
+				songs[i].error = e.what();
+			} catch (...) {
+				songs[i].error = "Unknown error occurred.";
+			}
+			// Lines are logged in the order the songs finish
+			unsigned int done = ++progress_done;
+			append_log("[" + std::to_string(done) + "/" + std::to_string(input_files.size()) + "] " + input_files[i]
+				+ (songs[i].cached ? " (cached)" : "") + (songs[i].error.empty() ? "" : " failed") + "\n");
+		});
+		if (export_cancelled)
+			throw Export_Cancelled();
+
+		// The per-song breakdown is only worked out when it is written, since
+		// it needs the linked data after every song.
+		Export_Analysis analysis;
+		bool analyse = settings.analysis_filename.size() > 0;
+		size_t seq_size = 0, pcm_size = 0;
 		for (size_t i = 0; i < input_files.size(); ++i) {
-			const auto& file = input_files[i];
-			std::string ext = fs::path(file).extension().string();
-			std::string filename_stem = fs::path(file).stem().string(); // Equivalent to get_filename in mdslink
-			
-			log += "[" + std::to_string(i+1) + "/" + std::to_string(input_files.size()) + "] " + file + "\n";
-
-			RIFF mds(0);
-			
-			if (iequal(ext, ".mds")) {
-				std::ifstream in(file, std::ios::binary | std::ios::ate);
-				if (in) {
-					auto size = in.tellg();
-					std::vector<uint8_t> data(size);
-					in.seekg(0);
-					if (in.read((char*)data.data(), size)) {
-						mds = RIFF(data);
-					} else {
-						status_message = "Failed to read " + file;
-						return;
-					}
-				} else {
-					status_message = "Failed to open " + file;
-					return;
-				}
-			} else {
-				// MML
-				Song song = convert_file(file, log);
-				MDSDRV_Converter converter(song);
-				mds = converter.get_mds();
+			if (!songs[i].error.empty())
+				throw std::runtime_error(songs[i].error);
+			std::string filename_stem = fs::path(input_files[i]).stem().string(); // Equivalent to get_filename in mdslink
+			linker.add_song(songs[i].mds, filename_stem);
+
+			if (analyse) {
+				size_t new_seq_size = linker.get_seq_data().size();
+				auto pcm_data = linker.get_pcm_data();
+				analysis.add_song(filename_stem, songs[i].mds.to_bytes(),
+					new_seq_size - seq_size, pcm_data.size() - pcm_size, pcm_data);
+				seq_size = new_seq_size;
+				pcm_size = pcm_data.size();
 			}
-			
-			linker.add_song(mds, filename_stem);
 		}
 		
-		log += "\n";
+		std::string log = "\n";
+		if (settings.use_cache) {
+			log += std::to_string(cache.get_hit_count()) + " song(s) from cache, "
+				+ std::to_string(cache.get_miss_count()) + " converted\n\n";
+			cache.prune();
+		}
+		append_log(log);
 
-		fs::path out_dir(output_path);
+		fs::path out_dir(settings.output_path);
 		if (!fs::exists(out_dir)) {
 			fs::create_directories(out_dir);
 		}
 
+		// Each bank is fetched from the linker in its own scope, so that only
+		// one copy is held at a time. The sizes are only needed for the
+		// summary, and are already known if the analysis was done.
+		bool need_sizes = analyse || settings.rom_budget;
+
 		// Write seq
-		if (strlen(seq_filename) > 0) {
-			fs::path p = out_dir / seq_filename;
-			log += "Writing " + p.string() + "...\n";
+		if (export_cancelled)
+			throw Export_Cancelled();
+		if (settings.seq_filename.size() > 0) {
 			auto bytes = linker.get_seq_data();
-			std::ofstream out(p, std::ios::binary);
-			out.write((char*)bytes.data(), bytes.size());
-			log += "  Wrote " + std::to_string(bytes.size()) + " bytes\n";
+			seq_size = bytes.size();
+			fs::path p = out_dir / settings.seq_filename;
+			append_log("Writing " + p.string() + "...\n");
+			append_log(write_output(p, bytes.data(), bytes.size()));
+		} else if (need_sizes && !analyse) {
+			seq_size = linker.get_seq_data().size();
 		}
 
 		// Write pcm
-		if (strlen(pcm_filename) > 0) {
-			fs::path p = out_dir / pcm_filename;
-			log += "Writing " + p.string() + "...\n";
+		if (export_cancelled)
+			throw Export_Cancelled();
+		if (settings.pcm_filename.size() > 0) {
 			auto bytes = linker.get_pcm_data();
-			std::ofstream out(p, std::ios::binary);
-			out.write((char*)bytes.data(), bytes.size());
-			log += "  Wrote " + std::to_string(bytes.size()) + " bytes\n";
-			log += "\n" + linker.get_statistics();
+			pcm_size = bytes.size();
+			fs::path p = out_dir / settings.pcm_filename;
+			append_log("Writing " + p.string() + "...\n");
+			append_log(write_output(p, bytes.data(), bytes.size()));
+			append_log("\n" + linker.get_statistics());
+		} else if (need_sizes && !analyse) {
+			pcm_size = linker.get_pcm_data().size();
 		}
+		analysis.set_output_size(seq_size, pcm_size);
+		analysis.set_budget(settings.rom_budget);
 
 		// Write header
-		if (strlen(header_filename) > 0) {
-			fs::path p = out_dir / header_filename;
-			log += "Writing " + p.string() + "...\n";
+		if (export_cancelled)
+			throw Export_Cancelled();
+		if (settings.header_filename.size() > 0) {
+			fs::path p = out_dir / settings.header_filename;
+			append_log("Writing " + p.string() + "...\n");
 			auto bytes = linker.get_c_header();
-			std::ofstream out(p);
-			out.write((char*)bytes.data(), bytes.size());
-			log += "  Wrote " + std::to_string(bytes.size()) + " bytes\n";
+			append_log(write_output(p, bytes.data(), bytes.size()));
 		}
+
+		// Write analysis
+		if (export_cancelled)
+			throw Export_Cancelled();
+		if (settings.analysis_filename.size() > 0) {
+			fs::path p = out_dir / settings.analysis_filename;
+			append_log("Writing " + p.string() + "...\n");
+			auto bytes = analysis.to_json();
+			append_log(write_output(p, bytes.data(), bytes.size()));
+		}
+		if (need_sizes)
+			append_log("\n" + analysis.get_summary());
 		
-		status_message = "Export Successful!\n\n" + log;
+		append_log("\nExport Successful!\n");
 
+	} catch (const Export_Cancelled&) {
+		append_log("\nExport cancelled.\n");
 	} catch (const std::exception& e) {
-		status_message = std::string("Error: ") + e.what();
+		append_log(std::string("\nError: ") + e.what() + "\n");
 	} catch (...) {
-		status_message = "Unknown error occurred.";
+		append_log("\nUnknown error occurred.\n");
 	}
+	export_running = false;
 }
-
@@ -2,26 +2,63 @@
 #define EXPORT_WINDOW_H
 
 #include "window.h"
+#include "directory_scan.h"
 #include "addons/imguifilesystem/imguifilesystem.h"
 #include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
 class Export_Window : public Window
 {
 	public:
 		Export_Window();
+		virtual ~Export_Window();
 		void display() override;
 
 	private:
+		struct Export_Settings
+		{
+			std::string bgm_path;
+			std::string sfx_path;
+			std::string output_path;
+			std::string seq_filename;
+			std::string pcm_filename;
+			std::string header_filename;
+			std::string analysis_filename;
+			size_t rom_budget;	// in bytes, 0 for no limit
+			bool use_cache;
+		};
+
 		char bgm_path[1024];
 		char sfx_path[1024];
 		char output_path[1024];
 		char seq_filename[256];
 		char pcm_filename[256];
 		char header_filename[256];
+		char analysis_filename[256];
+		int rom_budget;		// in KiB
 		
-		std::string status_message;
+		std::string status_message;	// protected by mutex during export
+		bool use_cache;
 		
-		void run_export();
+		void start_export();
+		void cancel_export();
+		void run_export(Export_Settings settings);
+		void append_log(const std::string& text);
+
+		std::unique_ptr<std::thread> worker_ptr;
+		std::mutex mutex;
+		std::atomic<bool> export_running;
+		std::atomic<bool> export_cancelled;
+		std::atomic<unsigned int> progress_done;
+		std::atomic<unsigned int> progress_total;
+
+		// Input directories are only walked again when they have changed.
+		// Only used by the export thread.
+		Directory_Scan bgm_scan;
+		Directory_Scan sfx_scan;
 
 		ImGuiFs::Dialog fs;
 		bool browse_bgm;
@@ -30,4 +67,3 @@ class Export_Window : public Window
 };
 
 #endif //EXPORT_WINDOW_H
-
@@ -1,5 +1,9 @@
 #include "main_window.h"
 #include "audio_manager.h"
+#include "emu_player.h"
+#include "pcm_batch.h"
+#include "dmf_library.h"
+#include "output_file.h"
 
 // dear imgui: standalone example application for GLFW + OpenGL 3, using programmable pipeline
 // If you are new to dear imgui, see examples/README.txt and documentation at the top of imgui.cpp.
@@ -107,6 +111,12 @@ int main(int argc, char* argv[])
 	int driver_id = -1;
 	int device_id = -1;
 	float ui_scale = 1.0f;
+	int buffer_length = -1;
+	const char* pcm_batch_input = nullptr;
+	const char* pcm_batch_output = nullptr;
+	PCM_Batch::Options pcm_batch_options;
+	const char* dmf_library_input = nullptr;
+	const char* dmf_library_output = nullptr;
 	int carg = 1;
 	while(carg < argc)
 	{
@@ -122,9 +132,115 @@ int main(int argc, char* argv[])
 		{
 			ui_scale = strtof(argv[++carg], NULL);
 		}
+		if(!std::strcmp(argv[carg], "--buffer-length") && (argc > carg + 1))
+		{
+			buffer_length = strtol(argv[++carg], NULL, 0);
+		}
+		if(!std::strcmp(argv[carg], "--max-players") && (argc > carg + 1))
+		{
+			Device_Pool::get()->set_max_players(strtol(argv[++carg], NULL, 0));
+		}
+		if(!std::strcmp(argv[carg], "--pcm-batch") && (argc > carg + 2))
+		{
+			pcm_batch_input = argv[++carg];
+			pcm_batch_output = argv[++carg];
+		}
+		if(!std::strcmp(argv[carg], "--dmf-library") && (argc > carg + 2))
+		{
+			dmf_library_input = argv[++carg];
+			dmf_library_output = argv[++carg];
+		}
+		if(!std::strcmp(argv[carg], "--pcm-rate") && (argc > carg + 1))
+		{
+			pcm_batch_options.target_rate = strtol(argv[++carg], NULL, 0);
+		}
+		if(!std::strcmp(argv[carg], "--pcm-slices") && (argc > carg + 1))
+		{
+			pcm_batch_options.slices = strtol(argv[++carg], NULL, 0);
+		}
+		if(!std::strcmp(argv[carg], "--pcm-quality") && (argc > carg + 1))
+		{
+			const char* quality = argv[++carg];
+			if(!std::strcmp(quality, "linear"))
+				pcm_batch_options.quality = Resampler::LINEAR;
+			else if(!std::strcmp(quality, "cubic"))
+				pcm_batch_options.quality = Resampler::CUBIC;
+			else
+				pcm_batch_options.quality = Resampler::SINC;
+		}
+		if(!std::strcmp(argv[carg], "--pcm-double-speed"))
+		{
+			pcm_batch_options.double_speed = true;
+		}
+		if(!std::strcmp(argv[carg], "--pcm-no-trim"))
+		{
+			pcm_batch_options.trim = false;
+		}
+		if(!std::strcmp(argv[carg], "--pcm-8bit"))
+		{
+			pcm_batch_options.bits_per_sample = 8;
+		}
+		if(!std::strcmp(argv[carg], "--pcm-no-cache"))
+		{
+			pcm_batch_options.use_cache = false;
+		}
+		if(!std::strcmp(argv[carg], "--jobs") && (argc > carg + 1))
+		{
+			pcm_batch_options.thread_count = strtol(argv[++carg], NULL, 0);
+		}
 		carg++;
 	}
 
+	// Batch conversion runs without the GUI
+	if(pcm_batch_input)
+	{
+		try
+		{
+			PCM_Batch batch(pcm_batch_options);
+			auto results = batch.run(pcm_batch_input, pcm_batch_output);
+			PCM_Batch::print_summary(results, stdout);
+			for(auto && i : results)
+			{
+				if(!i.successful)
+					return 1;
+			}
+			return 0;
+		}
+		catch(std::exception& e)
+		{
+			fprintf(stderr, "%s\n", e.what());
+			return 1;
+		}
+	}
+
+	// The instrument library is written as MML, with a table that maps
+	// each source instrument to its patch next to it.
+	if(dmf_library_input)
+	{
+		try
+		{
+			Dmf_Library library(pcm_batch_options.thread_count);
+			library.add_directory(dmf_library_input);
+			library.print_summary(stdout);
+
+			std::string mml = library.get_mml();
+			Output_File mml_file(dmf_library_output);
+			mml_file.write(mml.data(), mml.size());
+			mml_file.commit();
+
+			std::string map = library.get_mapping();
+			Output_File map_file(std::string(dmf_library_output) + ".tsv");
+			map_file.write(map.data(), map.size());
+			map_file.commit();
+			return library.get_errors().empty() ? 0 : 1;
+		}
+		catch(std::exception& e)
+		{
+			fprintf(stderr, "%s\n", e.what());
+			return 1;
+		}
+	}
+
 	// Setup window
 	glfwSetErrorCallback(glfw_error_callback);
 	if (!glfwInit())
@@ -133,6 +249,8 @@ int main(int argc, char* argv[])
 	glfwWindowHint(GLFW_SCALE_TO_MONITOR, GLFW_TRUE);
 
 	Audio_Manager::get().set_sample_rate(44100);
+	if(buffer_length >= 0)
+		Audio_Manager::get().set_buffer_length(buffer_length);
 
 	// Decide GL+GLSL versions
 #if __APPLE__
@@ -262,6 +380,9 @@ int main(int argc, char* argv[])
 		Window::modal_open = false;
 		main_window.display_all();
 
+		// stop streams that finished playing, outside of the audio thread
+		Audio_Manager::get().reap_streams();
+
 		// Rendering
 		ImGui::Render();
 		int display_w, display_h;
@@ -0,0 +1,90 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//! Map a file into memory.
+/*!
+ *  An empty file gives a null data pointer and a size of zero.
+ *
+ *  \exception std::runtime_error if the file can't be opened or mapped.
+ */
+Mapped_File::Mapped_File(const std::string& filename)
+	: address(nullptr)
+	, length(0)
+{
+#if defined(_WIN32)
+	file_handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	mapping_handle = NULL;
+	if(file_handle == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Failed to open " + filename);
+
+	LARGE_INTEGER file_size;
+	if(!GetFileSizeEx(file_handle, &file_size))
+	{
+		CloseHandle(file_handle);
+		throw std::runtime_error("Failed to read " + filename);
+	}
+	length = file_size.QuadPart;
+	if(length == 0)
+		return;
+
+	mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(mapping_handle)
+		address = (const uint8_t*)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	if(!address)
+	{
+		if(mapping_handle)
+			CloseHandle(mapping_handle);
+		CloseHandle(file_handle);
+		throw std::runtime_error("Failed to map " + filename);
+	}
+#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd < 0)
+		throw std::runtime_error("Failed to open " + filename);
+
+	struct stat st;
+	if(fstat(fd, &st) < 0)
+	{
+		close(fd);
+		throw std::runtime_error("Failed to read " + filename);
+	}
+	length = st.st_size;
+	if(length == 0)
+	{
+		close(fd);
+		return;
+	}
+
+	void* map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file
+	close(fd);
+	if(map == MAP_FAILED)
+		throw std::runtime_error("Failed to map " + filename);
+	address = (const uint8_t*)map;
+#endif
+}
+
+Mapped_File::~Mapped_File()
+{
+#if defined(_WIN32)
+	if(address)
+		UnmapViewOfFile(address);
+	if(mapping_handle)
+		CloseHandle(mapping_handle);
+	CloseHandle(file_handle);
+#else
+	if(address)
+		munmap((void*)address, length);
+#endif
+}
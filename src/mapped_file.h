@@ -0,0 +1,35 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+//! Read-only memory mapped file
+/*!
+ *  The file contents are paged in by the OS as they are accessed, so there
+ *  is no read into an intermediate buffer. The mapping is released when
+ *  the object is destroyed.
+ */
+class Mapped_File
+{
+	public:
+		Mapped_File(const std::string& filename);
+		~Mapped_File();
+
+		Mapped_File(Mapped_File const&) = delete;
+		void operator=(Mapped_File const&) = delete;
+
+		inline const uint8_t* data() const { return address; }
+		inline size_t size() const { return length; }
+
+	private:
+		const uint8_t* address;
+		size_t length;
+#if defined(_WIN32)
+		void* file_handle;
+		void* mapping_handle;
+#endif
+};
+
+#endif
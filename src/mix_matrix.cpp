@@ -0,0 +1,119 @@
+#include "mix_matrix.h"
+
+#include <cmath>
+#include <algorithm>
+
+//! Number of frames mixed at a time.
+const int Mix_Matrix::block_size = 256;
+
+//! constructs a Mix_Matrix with all gains set to zero.
+Mix_Matrix::Mix_Matrix(int input_channels, int output_channels)
+	: input_channels(std::max(input_channels, 1))
+	, output_channels(std::max(output_channels, 1))
+	, gains(this->input_channels * this->output_channels, 0.0f)
+{
+}
+
+//! Get the default matrix for changing the number of channels.
+/*!
+ *  Mono output is the average of all channels, and mono input is copied to
+ *  all outputs. Stereo output from more channels assumes the WAVE channel
+ *  order (front left, front right, center, LFE, then left/right pairs); the
+ *  LFE channel is dropped and each row is normalized so that full scale
+ *  input can not clip. Otherwise channels are passed through one to one.
+ */
+Mix_Matrix Mix_Matrix::downmix(int input_channels, int output_channels)
+{
+	Mix_Matrix matrix(input_channels, output_channels);
+	int in = matrix.input_channels;
+	int out = matrix.output_channels;
+
+	if(out == 1)
+	{
+		for(int i = 0; i < in; i++)
+			matrix.set(0, i, 1.0f / in);
+	}
+	else if(in == 1)
+	{
+		for(int o = 0; o < out; o++)
+			matrix.set(o, 0, 1.0f);
+	}
+	else if(out == 2 && in > 2)
+	{
+		const float side = std::sqrt(0.5f);
+		matrix.set(0, 0, 1.0f);
+		matrix.set(1, 1, 1.0f);
+		matrix.set(0, 2, side);
+		matrix.set(1, 2, side);
+		for(int i = 4; i < in; i++)
+			matrix.set(i & 1, i, side);
+		for(int o = 0; o < 2; o++)
+		{
+			float sum = 0.0f;
+			for(int i = 0; i < in; i++)
+				sum += matrix.get(o, i);
+			for(int i = 0; i < in; i++)
+				matrix.set(o, i, matrix.get(o, i) / sum);
+		}
+	}
+	else
+	{
+		for(int i = 0; i < std::min(in, out); i++)
+			matrix.set(i, i, 1.0f);
+	}
+	return matrix;
+}
+
+//! Get a matrix that extracts a single channel to mono.
+Mix_Matrix Mix_Matrix::select(int input_channels, int channel)
+{
+	Mix_Matrix matrix(input_channels, 1);
+	if(channel >= 0 && channel < matrix.input_channels)
+		matrix.set(0, channel, 1.0f);
+	return matrix;
+}
+
+//! Mix interleaved samples.
+/*!
+ *  output must have room for frames * output channels samples. If there
+ *  are no more output channels than input channels, output may point to
+ *  the same buffer as input.
+ */
+void Mix_Matrix::process(const int16_t* input, int16_t* output, size_t frames) const
+{
+	std::vector<float> planes(input_channels * block_size);
+	std::vector<float> accumulator(block_size);
+
+	for(size_t block_start = 0; block_start < frames; block_start += block_size)
+	{
+		int count = std::min<size_t>(block_size, frames - block_start);
+		const int16_t* in = input + block_start * input_channels;
+		int16_t* out = output + block_start * output_channels;
+
+		// Deinterleave the whole block first, which also makes in-place
+		// processing safe.
+		for(int c = 0; c < input_channels; c++)
+		{
+			float* plane = planes.data() + c * block_size;
+			for(int i = 0; i < count; i++)
+				plane[i] = in[i * input_channels + c];
+		}
+
+		for(int o = 0; o < output_channels; o++)
+		{
+			float* acc = accumulator.data();
+			std::fill_n(acc, count, 0.0f);
+			for(int c = 0; c < input_channels; c++)
+			{
+				float gain = get(o, c);
+				if(gain == 0.0f)
+					continue;
+				const float* plane = planes.data() + c * block_size;
+				for(int i = 0; i < count; i++)
+					acc[i] += gain * plane[i];
+			}
+			for(int i = 0; i < count; i++)
+				out[i * output_channels + o] = std::lrint(std::min(std::max(acc[i], -32768.0f), 32767.0f));
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef MIX_MATRIX_H
+#define MIX_MATRIX_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//! Channel mixing matrix for interleaved PCM data
+/*!
+ *  Each output channel is a weighted sum of the input channels. process()
+ *  works on blocks of frames that are converted to separate float arrays per
+ *  channel, so that the inner loops are plain multiply-adds over contiguous
+ *  data which the compiler can vectorize.
+ */
+class Mix_Matrix
+{
+	public:
+		Mix_Matrix(int input_channels, int output_channels);
+
+		static Mix_Matrix downmix(int input_channels, int output_channels);
+		static Mix_Matrix select(int input_channels, int channel);
+
+		inline int get_input_channels() const { return input_channels; }
+		inline int get_output_channels() const { return output_channels; }
+
+		inline float get(int output, int input) const { return gains[output * input_channels + input]; }
+		inline void set(int output, int input, float gain) { gains[output * input_channels + input] = gain; }
+
+		void process(const int16_t* input, int16_t* output, size_t frames) const;
+
+	private:
+		const static int block_size;
+
+		int input_channels;
+		int output_channels;
+		std::vector<float> gains;	// output_channels rows of input_channels
+};
+
+#endif
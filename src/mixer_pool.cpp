@@ -0,0 +1,97 @@
+#include "mixer_pool.h"
+
+//! constructs a Mixer_Pool
+/*!
+ *  \param thread_count number of worker threads, in addition to the
+ *         thread calling run().
+ */
+Mixer_Pool::Mixer_Pool(unsigned int thread_count)
+	: threads()
+	, quit(false)
+	, generation(0)
+	, job_count(0)
+	, job_function(nullptr)
+	, job_context(nullptr)
+	, next_job(0)
+	, jobs_done(0)
+{
+	for(unsigned int i = 0; i < thread_count; i++)
+		threads.emplace_back(&Mixer_Pool::worker, this);
+}
+
+Mixer_Pool::~Mixer_Pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	condition_variable.notify_all();
+	for(auto && i : threads)
+		i.join();
+}
+
+//! Run jobs and wait until all are done.
+/*!
+ *  function is called once for each index from 0 to job_count - 1. The
+ *  calls may happen in any order and from any thread.
+ */
+void Mixer_Pool::run(unsigned int job_count, Job_Function function, void* context)
+{
+	uint32_t current_generation;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		current_generation = ++generation;
+		this->job_count = job_count;
+		job_function = function;
+		job_context = context;
+		jobs_done.store(0, std::memory_order_relaxed);
+		next_job.store((uint64_t)current_generation << 32, std::memory_order_release);
+	}
+	condition_variable.notify_all();
+
+	process(current_generation, job_count, function, context);
+
+	// wait for jobs taken by the worker threads
+	while(jobs_done.load(std::memory_order_acquire) < job_count)
+		std::this_thread::yield();
+}
+
+//! Worker thread
+void Mixer_Pool::worker()
+{
+	uint32_t last_generation = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	while(!quit)
+	{
+		if(generation != last_generation)
+		{
+			last_generation = generation;
+			unsigned int count = job_count;
+			Job_Function function = job_function;
+			void* context = job_context;
+
+			lock.unlock();
+			process(last_generation, count, function, context);
+			lock.lock();
+		}
+		else
+		{
+			condition_variable.wait(lock);
+		}
+	}
+}
+
+//! Take and process jobs until there are none left in this generation.
+void Mixer_Pool::process(uint32_t current_generation, unsigned int count, Job_Function function, void* context)
+{
+	uint64_t job = next_job.load(std::memory_order_acquire);
+	while((job >> 32) == current_generation && (job & 0xffffffff) < count)
+	{
+		if(next_job.compare_exchange_weak(job, job + 1, std::memory_order_acq_rel))
+		{
+			function(context, job & 0xffffffff);
+			jobs_done.fetch_add(1, std::memory_order_release);
+			job = next_job.load(std::memory_order_acquire);
+		}
+	}
+}
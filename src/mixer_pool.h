@@ -0,0 +1,53 @@
+#ifndef MIXER_POOL_H
+#define MIXER_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+
+//! Worker threads for rendering audio streams in parallel
+/*!
+ *  run() is called from the audio callback. It hands out jobs to the
+ *  worker threads and also processes jobs itself, returning once all jobs
+ *  are done. No memory is allocated while jobs are running.
+ */
+class Mixer_Pool
+{
+	public:
+		typedef void (*Job_Function)(void* context, unsigned int index);
+
+		Mixer_Pool(unsigned int thread_count);
+		virtual ~Mixer_Pool();
+
+		Mixer_Pool(Mixer_Pool const&) = delete;
+		void operator=(Mixer_Pool const&) = delete;
+
+		void run(unsigned int job_count, Job_Function function, void* context);
+
+		inline unsigned int get_thread_count() const { return threads.size(); }
+
+	private:
+		void worker();
+		void process(uint32_t generation, unsigned int job_count, Job_Function function, void* context);
+
+		std::vector<std::thread> threads;
+
+		std::mutex mutex;
+		std::condition_variable condition_variable;
+		bool quit;
+
+		// job state, protected by mutex
+		uint32_t generation;
+		unsigned int job_count;
+		Job_Function job_function;
+		void* job_context;
+
+		// generation in upper 32 bits, next job index in lower 32 bits
+		std::atomic<uint64_t> next_job;
+		std::atomic<unsigned int> jobs_done;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "output_file.h"
+
+#include <filesystem>
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+//! Size of the blocks used for comparing and copying.
+static const size_t block_size = 64 * 1024;
+
+//! constructs an Output_File
+/*!
+ *  Nothing is written until the data differs from the existing file.
+ */
+Output_File::Output_File(const std::string& filename)
+	: filename(filename)
+	, temp_filename(filename + ".tmp")
+	, existing(fopen(filename.c_str(), "rb"))
+	, temp(nullptr)
+	, size(0)
+	, committed(false)
+{
+	if(!existing)
+		start_temp_file();
+}
+
+//! Remove the temporary file if the output was not committed.
+Output_File::~Output_File()
+{
+	if(existing)
+		fclose(existing);
+	if(temp)
+	{
+		fclose(temp);
+		std::error_code ec;
+		fs::remove(temp_filename, ec);
+	}
+}
+
+//! Open the temporary file and copy the part that matched the existing file.
+void Output_File::start_temp_file()
+{
+	temp = fopen(temp_filename.c_str(), "wb");
+	if(!temp)
+		throw std::runtime_error("Failed to open " + temp_filename + " for writing");
+
+	if(existing)
+	{
+		uint8_t buffer[block_size];
+		rewind(existing);
+		for(size_t position = 0; position < size;)
+		{
+			size_t length = std::min(size - position, block_size);
+			if(fread(buffer, 1, length, existing) != length || fwrite(buffer, 1, length, temp) != length)
+				throw std::runtime_error("Failed to write " + temp_filename);
+			position += length;
+		}
+		fclose(existing);
+		existing = nullptr;
+	}
+}
+
+//! Append data to the file.
+/*!
+ *  \exception std::runtime_error if the temporary file can't be written.
+ */
+void Output_File::write(const void* data, size_t length)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	while(existing && length)
+	{
+		uint8_t buffer[block_size];
+		size_t compare_length = std::min(length, block_size);
+		size_t read = fread(buffer, 1, compare_length, existing);
+		size_t same = 0;
+		while(same < read && buffer[same] == bytes[same])
+			same++;
+		size += same;
+		bytes += same;
+		length -= same;
+		if(same < compare_length)
+			start_temp_file();
+	}
+	if(length && fwrite(bytes, 1, length, temp) != length)
+		throw std::runtime_error("Failed to write " + temp_filename);
+	size += length;
+}
+
+//! Finish the file.
+/*!
+ *  \return true if the file was replaced, false if it was unchanged.
+ *  \exception std::runtime_error if the file can't be written.
+ */
+bool Output_File::commit()
+{
+	if(committed)
+		return false;
+	committed = true;
+
+	// The existing file may be longer than the new data
+	if(existing && fgetc(existing) != EOF)
+		start_temp_file();
+
+	if(existing)
+	{
+		fclose(existing);
+		existing = nullptr;
+		return false;
+	}
+
+	int status = fclose(temp);
+	temp = nullptr;
+	std::error_code ec;
+	if(status == 0)
+		fs::rename(temp_filename, filename, ec);
+	if(status != 0 || ec)
+	{
+		fs::remove(temp_filename, ec);
+		throw std::runtime_error("Failed to write " + filename);
+	}
+	return true;
+}
@@ -0,0 +1,45 @@
+#ifndef OUTPUT_FILE_H
+#define OUTPUT_FILE_H
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+//! Streaming file writer that replaces the target atomically
+/*!
+ *  Data is written to a temporary file next to the target, which replaces
+ *  the target in commit(). An interrupted write therefore never leaves a
+ *  truncated file behind.
+ *
+ *  While the data matches the existing file, nothing is written. If the
+ *  whole file turns out to be the same, the existing file is not touched,
+ *  so its timestamp stays the same. Otherwise the matching part is copied
+ *  from the existing file once the first difference is found.
+ */
+class Output_File
+{
+	public:
+		Output_File(const std::string& filename);
+		~Output_File();
+
+		Output_File(Output_File const&) = delete;
+		void operator=(Output_File const&) = delete;
+
+		void write(const void* data, size_t length);
+		bool commit();
+
+		inline size_t get_size() const { return size; }
+
+	private:
+		void start_temp_file();
+
+		std::string filename;
+		std::string temp_filename;
+		FILE* existing;		// open while the data matches the existing file
+		FILE* temp;			// open once the data differs
+		size_t size;
+		bool committed;
+};
+
+#endif
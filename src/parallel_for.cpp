@@ -0,0 +1,43 @@
+#include "parallel_for.h"
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+//! Run a function for each index from 0 to count - 1 using worker threads.
+/*!
+ *  Indexes are handed out in order, but may complete in any order. Use this
+ *  for batches of long running jobs such as file conversion; the audio
+ *  callback uses Mixer_Pool instead.
+ *
+ *  \param thread_count maximum number of threads, or 0 to use
+ *         get_default_thread_count().
+ */
+void parallel_for(unsigned int count, unsigned int thread_count, const std::function<void(unsigned int)>& function)
+{
+	if(!thread_count)
+		thread_count = get_default_thread_count();
+	thread_count = std::min(thread_count, count);
+
+	std::atomic<unsigned int> next_index(0);
+	auto worker = [&]()
+	{
+		unsigned int index;
+		while((index = next_index++) < count)
+			function(index);
+	};
+
+	std::vector<std::thread> threads;
+	for(unsigned int i = 1; i < thread_count; i++)
+		threads.emplace_back(worker);
+	worker();
+	for(auto && i : threads)
+		i.join();
+}
+
+//! Get the number of hardware threads, or 1 if unknown.
+unsigned int get_default_thread_count()
+{
+	return std::max(std::thread::hardware_concurrency(), 1u);
+}
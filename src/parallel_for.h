@@ -0,0 +1,10 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <functional>
+
+void parallel_for(unsigned int count, unsigned int thread_count, const std::function<void(unsigned int)>& function);
+
+unsigned int get_default_thread_count();
+
+#endif
@@ -0,0 +1,279 @@
+#include "pcm_batch.h"
+#include "audio_decoder.h"
+#include "parallel_for.h"
+#include "content_hash.h"
+
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+//! Name of the cache file in the output directory.
+static const char* cache_filename = ".pcm_batch_cache";
+static const char* cache_header = "# mmlgui PCM batch cache v1";
+
+//! Default options, matching the PCM tool.
+PCM_Batch::Options::Options()
+	: target_rate(17500)
+	, quality(Resampler::SINC)
+	, double_speed(false)
+	, slices(1)
+	, trim(true)
+	, trim_threshold(256)
+	, thread_count(0)
+	, bits_per_sample(16)
+	, use_cache(true)
+{
+}
+
+//! constructs a PCM_Batch
+PCM_Batch::PCM_Batch(const Options& options)
+	: options(options)
+{
+	if(this->options.slices < 1)
+		this->options.slices = 1;
+}
+
+//! Convert all supported audio files in a directory.
+/*!
+ *  Files are converted in parallel, but the results are returned sorted by
+ *  file name. Files whose names differ only in the extension are not
+ *  converted, since their outputs would have the same name.
+ *
+ *  \exception std::filesystem::filesystem_error if the input directory
+ *             can't be read or the output directory can't be created.
+ */
+std::vector<PCM_Batch::Result> PCM_Batch::run(const std::string& input_path, const std::string& output_path) const
+{
+	std::vector<std::string> files;
+	for(auto && entry : fs::directory_iterator(input_path))
+	{
+		if(!entry.is_regular_file())
+			continue;
+		std::string ext = entry.path().extension().string();
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		if(ext == ".wav" || ext == ".mp3" || ext == ".flac" || ext == ".ogg")
+			files.push_back(entry.path().string());
+	}
+	std::sort(files.begin(), files.end());
+
+	fs::create_directories(output_path);
+
+	std::string cache_path = (fs::path(output_path) / cache_filename).string();
+	Cache cache;
+	if(options.use_cache)
+		cache = read_cache(cache_path);
+
+	// Outputs are named after the input without its extension, so files
+	// such as kick.wav and kick.mp3 would overwrite each other. None of
+	// them are converted. Names are compared without case, as on Windows.
+	std::map<std::string, std::vector<size_t>> by_name;
+	for(size_t i = 0; i < files.size(); i++)
+	{
+		std::string name = fs::path(files[i]).stem().string();
+		std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+		by_name[name].push_back(i);
+	}
+
+	std::vector<Result> results(files.size());
+	for(auto && i : by_name)
+	{
+		if(i.second.size() < 2)
+			continue;
+		for(auto index : i.second)
+		{
+			std::string others;
+			for(auto other : i.second)
+				if(other != index)
+					others += (others.size() ? ", " : "") + fs::path(files[other]).filename().string();
+			results[index].input = files[index];
+			results[index].message = "Output name is also used by " + others;
+		}
+	}
+
+	parallel_for(files.size(), options.thread_count, [&](unsigned int index)
+	{
+		if(results[index].message.empty())
+			convert(files[index], output_path, cache, results[index]);
+	});
+
+	write_cache(cache_path, results);
+	return results;
+}
+
+//! Get a string describing the options that affect the output.
+std::string PCM_Batch::get_options_key() const
+{
+	std::ostringstream key;
+	key << options.target_rate << " " << options.quality << " " << options.double_speed << " "
+		<< options.slices << " " << options.trim << " " << options.trim_threshold << " "
+		<< options.bits_per_sample;
+	return key.str();
+}
+
+//! Convert a single file.
+/*!
+ *  The file is skipped if the cache has an entry with the same hash and
+ *  all outputs of that entry exist. Errors are stored in the result.
+ */
+void PCM_Batch::convert(const std::string& input_file, const std::string& output_path, const Cache& cache, Result& result) const
+{
+	auto start_time = std::chrono::steady_clock::now();
+
+	result.input = input_file;
+	result.successful = false;
+	result.cached = false;
+	result.input_rate = 0;
+	result.input_channels = 0;
+	result.input_frames = 0;
+	result.output_samples = 0;
+
+	try
+	{
+		Content_Hash hash;
+		hash.add_file(input_file);
+		hash.add(get_options_key());
+		result.hash = hash.to_string();
+
+		auto entry = cache.find(input_file);
+		if(entry != cache.end() && entry->second.first == result.hash)
+		{
+			const std::vector<std::string>& outputs = entry->second.second;
+			if(std::all_of(outputs.begin(), outputs.end(), [](const std::string& i) { return fs::exists(i); }))
+			{
+				result.outputs = outputs;
+				result.successful = true;
+				result.cached = true;
+				result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+				return;
+			}
+		}
+
+		Wave_Data wave = load_audio_file(input_file);
+		result.input_rate = wave.sample_rate;
+		result.input_channels = wave.channels;
+		result.input_frames = wave.get_frames();
+
+		// Downmix in place, the interleaved data is not needed afterwards
+		std::vector<int16_t>& mono = wave.samples;
+		downmix_to_mono(mono.data(), mono.data(), result.input_frames, wave.channels);
+		mono.resize(result.input_frames);
+
+		size_t start = 0;
+		size_t end = mono.size();
+		if(options.trim)
+		{
+			auto loud = [this](int16_t sample) { return std::abs(sample) >= options.trim_threshold; };
+			start = std::find_if(mono.begin(), mono.end(), loud) - mono.begin();
+			end = mono.rend() - std::find_if(mono.rbegin(), mono.rend(), loud);
+			if(start >= end)
+				throw std::runtime_error("File is silent");
+		}
+
+		uint32_t rate = options.target_rate;
+		if(options.double_speed)
+			rate /= 2;
+		Resampler resampler(wave.sample_rate, rate, options.quality);
+		std::vector<int16_t> output = resampler.process(mono.data() + start, end - start);
+		result.output_samples = output.size();
+
+		// Slices are named the same way as in the PCM tool
+		std::string base_path = (fs::path(output_path) / fs::path(input_file).stem()).string();
+		size_t slice_length = output.size() / options.slices;
+		for(unsigned int slice = 0; slice < options.slices; slice++)
+		{
+			size_t slice_start = slice * slice_length;
+			size_t slice_end = (slice == options.slices - 1) ? output.size() : slice_start + slice_length;
+			std::string filename = (options.slices == 1)
+				? base_path + ".wav"
+				: base_path + "-" + std::to_string(slice + 1) + ".wav";
+			save_wave_file(filename, output.data() + slice_start, slice_end - slice_start, options.target_rate, 1, options.bits_per_sample);
+			result.outputs.push_back(filename);
+		}
+		result.successful = true;
+	}
+	catch(std::exception& e)
+	{
+		result.message = e.what();
+	}
+
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+//! Read the cache file. A missing or invalid file gives an empty cache.
+PCM_Batch::Cache PCM_Batch::read_cache(const std::string& filename)
+{
+	Cache cache;
+	std::ifstream in(filename);
+	std::string line;
+	if(!std::getline(in, line) || line != cache_header)
+		return cache;
+	while(std::getline(in, line))
+	{
+		// hash, input and outputs, separated by tabs
+		std::vector<std::string> fields;
+		std::istringstream stream(line);
+		std::string field;
+		while(std::getline(stream, field, '\t'))
+			fields.push_back(field);
+		if(fields.size() < 3)
+			continue;
+		cache[fields[1]] = {fields[0], std::vector<std::string>(fields.begin() + 2, fields.end())};
+	}
+	return cache;
+}
+
+//! Write the cache file for the successfully converted files.
+/*!
+ *  Failing to write the cache is not an error, the files are just
+ *  converted again next time.
+ */
+void PCM_Batch::write_cache(const std::string& filename, const std::vector<Result>& results)
+{
+	std::ofstream out(filename);
+	out << cache_header << "\n";
+	for(auto && i : results)
+	{
+		if(!i.successful)
+			continue;
+		out << i.hash << "\t" << i.input;
+		for(auto && output : i.outputs)
+			out << "\t" << output;
+		out << "\n";
+	}
+}
+
+//! Print one line per file and a total.
+void PCM_Batch::print_summary(const std::vector<Result>& results, FILE* output)
+{
+	unsigned int ok_count = 0;
+	unsigned int cached_count = 0;
+	unsigned int output_count = 0;
+	for(auto && i : results)
+	{
+		std::string name = fs::path(i.input).filename().string();
+		if(i.cached)
+		{
+			fprintf(output, "%s: up to date\n", name.c_str());
+			ok_count++;
+			cached_count++;
+		}
+		else if(i.successful)
+		{
+			fprintf(output, "%s: %u Hz, %u ch, %zu frames -> %zu samples in %zu file(s) (%.1f ms)\n",
+				name.c_str(), i.input_rate, i.input_channels, i.input_frames,
+				i.output_samples, i.outputs.size(), i.seconds * 1000.0);
+			ok_count++;
+			output_count += i.outputs.size();
+		}
+		else
+		{
+			fprintf(output, "%s: failed: %s\n", name.c_str(), i.message.c_str());
+		}
+	}
+	fprintf(output, "Converted %u of %zu files (%u up to date), wrote %u files.\n", ok_count, results.size(), cached_count, output_count);
+}
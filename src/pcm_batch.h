@@ -0,0 +1,74 @@
+#ifndef PCM_BATCH_H
+#define PCM_BATCH_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <cstdint>
+
+#include "resampler.h"
+
+//! Converts a directory of audio files to PCM samples for MDSDRV
+/*!
+ *  Each file is processed the same way as an export from the PCM tool:
+ *  downmix to mono, trim, resample, optional speed doubling and slicing.
+ *  Files are converted in parallel.
+ *
+ *  A cache file in the output directory records a hash of each input file
+ *  and the options used. Files that have not changed since the last run
+ *  are skipped, as long as their outputs still exist.
+ */
+class PCM_Batch
+{
+	public:
+		struct Options
+		{
+			uint32_t target_rate;
+			Resampler::Quality quality;
+			bool double_speed;
+			unsigned int slices;
+			bool trim;
+			int16_t trim_threshold;		// samples with lower absolute amplitude are trimmed
+			unsigned int thread_count;	// 0 = one per hardware thread
+			int bits_per_sample;		// 8 = MDSDRV native format
+			bool use_cache;
+
+			Options();
+		};
+
+		struct Result
+		{
+			std::string input;
+			std::vector<std::string> outputs;
+			bool successful;
+			bool cached;				// outputs were up to date
+			std::string message;
+			std::string hash;			// input contents and options
+
+			uint32_t input_rate;
+			uint16_t input_channels;
+			size_t input_frames;
+			size_t output_samples;
+			double seconds;
+		};
+
+		PCM_Batch(const Options& options);
+
+		std::vector<Result> run(const std::string& input_path, const std::string& output_path) const;
+
+		static void print_summary(const std::vector<Result>& results, FILE* output);
+
+	private:
+		typedef std::map<std::string, std::pair<std::string, std::vector<std::string>>> Cache;
+
+		void convert(const std::string& input_file, const std::string& output_path, const Cache& cache, Result& result) const;
+		std::string get_options_key() const;
+
+		static Cache read_cache(const std::string& filename);
+		static void write_cache(const std::string& filename, const std::vector<Result>& results);
+
+		Options options;
+};
+
+#endif
@@ -11,20 +11,34 @@
 #include <sys/stat.h>
 #include "stringf.h"
 #include "audio_manager.h"
+#include "audio_decoder.h"
+#include "resampler.h"
+#include "mix_matrix.h"
+
+//! Sample rate of exported PCM data.
+static const int export_rate = 17500;
 
 // Simple Audio Stream for Preview
+// Plays interleaved data with any number of channels, mixed to stereo with the given matrix.
 class PCM_Preview_Stream : public Audio_Stream
 {
 public:
-    PCM_Preview_Stream(const std::vector<short>& data, int start, int end, int rate, bool loop, int* position_ptr)
-        : data(data), start(start), end(end), rate(rate), loop(loop), pos(0.0), step(0.0), position_ptr(position_ptr)
+    PCM_Preview_Stream(std::shared_ptr<const Sample_Buffer::Data> buffer, int source_channels, const Mix_Matrix& mix, int start, int end, int rate, bool loop)
+        : buffer(buffer), data(*buffer), source_channels(source_channels), frames((int)(buffer->size() / source_channels)),
+          left_gain(source_channels), right_gain(source_channels),
+          start(start), end(end), rate(rate), loop(loop), pos(0.0), step(0.0)
     {
+        for (int c = 0; c < source_channels; ++c) {
+            left_gain[c] = mix.get(0, c);
+            right_gain[c] = mix.get(1, c);
+        }
         if (this->start < 0) this->start = 0;
-        if (this->end > (int)this->data.size()) this->end = (int)this->data.size();
+        if (this->end > frames) this->end = frames;
         if (this->start >= this->end) {
              this->start = 0;
              this->end = 0;
         }
+        set_position(this->start);
     }
 
     void setup_stream(uint32_t output_rate) override
@@ -39,30 +53,13 @@ public:
     int get_sample(WAVE_32BS* output, int count, int channels) override
     {
         if (start >= end) {
-            // Fill with silence if empty
-             for (int i = 0; i < count; ++i) {
-                output[i].L = 0;
-                output[i].R = 0;
-            }
+            // Nothing to play, leave the output buffer untouched
             if (!finished) set_finished(true);
             return 0;
         }
 
         for (int i = 0; i < count; ++i)
         {
-            // Update current playback position (in original sample indices) before processing
-            if (position_ptr) {
-                int current_idx = start + (int)pos;
-                // Handle looping
-                if (loop && current_idx >= end) {
-                    current_idx = start + ((current_idx - start) % (end - start));
-                }
-                // Clamp to valid range
-                if (current_idx < start) current_idx = start;
-                if (current_idx > end) current_idx = end;
-                *position_ptr = current_idx;
-            }
-            
             int idx0 = start + (int)pos;
             int idx1 = idx0 + 1;
             
@@ -76,11 +73,8 @@ public:
                 }
                 else
                 {
-                    // Silence rest of buffer
-                    for (; i < count; ++i) {
-                        output[i].L = 0;
-                        output[i].R = 0;
-                    }
+                    // Leave the rest of the buffer silent
+                    set_position(end);
                     if (!finished) set_finished(true);
                     return 0;
                 }
@@ -95,23 +89,34 @@ public:
             // Ensure indices are within valid data bounds (safety check)
             if (idx0 < 0) idx0 = 0;
             if (idx1 < 0) idx1 = 0;
-            if (idx0 >= (int)data.size()) idx0 = (int)data.size() - 1;
-            if (idx1 >= (int)data.size()) idx1 = (int)data.size() - 1;
-
-            double frac = pos - (int)pos;
-            short s0 = data[idx0];
-            short s1 = data[idx1];
-            
-            // Linear interpolation
-            int32_t val = (int32_t)(s0 + (s1 - s0) * frac);
+            if (idx0 >= frames) idx0 = frames - 1;
+            if (idx1 >= frames) idx1 = frames - 1;
+
+            float frac = pos - (int)pos;
+            const int16_t* frame0 = &data[(size_t)idx0 * source_channels];
+            const int16_t* frame1 = &data[(size_t)idx1 * source_channels];
+
+            // Linear interpolation, then mix to stereo
+            float left = 0.0f;
+            float right = 0.0f;
+            for (int c = 0; c < source_channels; ++c) {
+                float val = frame0[c] + (frame1[c] - frame0[c]) * frac;
+                left += left_gain[c] * val;
+                right += right_gain[c] * val;
+            }
 
             // Mixer expects 8.24 fixed point or similar scaling (shifted down by 8 in callback)
-            output[i].L = val << 8;
-            output[i].R = val << 8; 
+            output[i].L += (int32_t)(left * 256.0f);
+            output[i].R += (int32_t)(right * 256.0f);
 
             pos += step;
         }
-        
+
+        // Publish the playback position in original sample indices
+        int current_idx = start + (int)pos;
+        if (loop && current_idx >= end)
+            current_idx = start + ((current_idx - start) % (end - start));
+        set_position(std::min(current_idx, end));
         return 1;
     }
 
@@ -120,14 +125,18 @@ public:
     }
 
 private:
-    std::vector<short> data; // Copy of data for thread safety
+    std::shared_ptr<const Sample_Buffer::Data> buffer; // Keeps the data alive while playing
+    const Sample_Buffer::Data& data;
+    int source_channels;
+    int frames;
+    std::vector<float> left_gain;
+    std::vector<float> right_gain;
     int start;
     int end;
     int rate;
     bool loop;
     double pos;
     double step;
-    int* position_ptr; // Pointer to update current playback position
 };
 
 PCM_Tool_Window::PCM_Tool_Window() : Window(), fs(true, false, true), browse_open(false), browse_save(false)
@@ -139,7 +148,10 @@ PCM_Tool_Window::PCM_Tool_Window() : Window(), fs(true, false, true), browse_ope
     end_point = 0;
     preview_loop = false;
     double_speed = false;
-    current_playback_position = -1;
+    resample_quality = Resampler::SINC;
+    export_channel = -1;
+    stereo_preview = true;
+    native_format = false;
     zoom_enabled = false;
     zoom_point = 0; // Default to start point
     zoom_level = 1.0f;
@@ -152,11 +164,46 @@ PCM_Tool_Window::PCM_Tool_Window() : Window(), fs(true, false, true), browse_ope
     initial_position = ImVec2(0, 0);
 }
 
-float PCM_Tool_Window::WaveformGetter(void* data, int idx)
+//! Draw samples [start, end) of the waveform inside a rectangle.
+/*!
+ *  When there are more samples than pixels, each pixel column is drawn as
+ *  a vertical line between the minimum and maximum from the peak pyramid.
+ */
+void PCM_Tool_Window::draw_waveform(ImDrawList* draw_list, const ImVec2& min, const ImVec2& max, int start, int end)
 {
-    const std::vector<short>* pcm = (const std::vector<short>*)data;
-    if (idx < 0 || idx >= (int)pcm->size()) return 0.0f;
-    return (float)(*pcm)[idx] / 32768.0f;
+    draw_list->AddRectFilled(min, max, ImGui::GetColorU32(ImGuiCol_FrameBg));
+
+    int length = end - start;
+    float width = max.x - min.x;
+    if (length <= 0 || width < 1.0f) return;
+
+    ImU32 color = ImGui::GetColorU32(ImGuiCol_PlotLines);
+    float center = (min.y + max.y) * 0.5f;
+    float scale = (max.y - min.y) * 0.5f / 32768.0f;
+
+    if (length > width) {
+        int columns = (int)width;
+        double samples_per_column = (double)length / columns;
+        for (int x = 0; x < columns; ++x) {
+            size_t column_start = start + (size_t)(x * samples_per_column);
+            size_t column_end = start + (size_t)((x + 1) * samples_per_column);
+            Waveform_Overview::Peak peak = waveform.get_peak(column_start, std::max(column_end, column_start + 1));
+            float px = min.x + x + 0.5f;
+            draw_list->AddLine(ImVec2(px, center - peak.max * scale), ImVec2(px, center - peak.min * scale + 1.0f), color);
+        }
+    } else {
+        // Draw each channel separately when zoomed in far enough
+        float x_step = width / (length > 1 ? length - 1 : 1);
+        for (int c = 0; c < channels; ++c) {
+            const int16_t* samples = pcm_data.data() + (size_t)start * channels + c;
+            ImVec2 previous(min.x, center - samples[0] * scale);
+            for (int i = 1; i < length; ++i) {
+                ImVec2 point(min.x + i * x_step, center - samples[(size_t)i * channels] * scale);
+                draw_list->AddLine(previous, point, color);
+                previous = point;
+            }
+        }
+    }
 }
 
 void PCM_Tool_Window::display()
@@ -227,7 +274,7 @@ void PCM_Tool_Window::display()
             ImVec2 pos = ImVec2(center.x - size.x * 0.5f, center.y - size.y * 0.5f);
 
             // Ensure we don't pass browse_open directly if the dialog expects a trigger button press only once
-            const char* path = fs.chooseFileDialog(load_clicked, input_path, ".wav;.mp3", "Load Audio", size, pos);
+            const char* path = fs.chooseFileDialog(load_clicked, input_path, AUDIO_FILE_FILTER, "Load Audio", size, pos);
             if (strlen(path) > 0)
             {
                 load_file(path);
@@ -239,14 +286,31 @@ void PCM_Tool_Window::display()
             }
         }
 
-        if (pcm_data.size() > 0)
+        if (!pcm_data.empty())
         {
             ImGui::Separator();
             ImGui::Text("Sample Rate: %d Hz", sample_rate);
             ImGui::SameLine();
             ImGui::Text("Channels: %d", channels);
             ImGui::SameLine();
-            ImGui::Text("Length: %d samples", (int)pcm_data.size());
+            ImGui::Text("Length: %d samples", (int)get_frame_count());
+            if (channels > 1) {
+                // Multichannel data is kept as is, and mixed to mono on export
+                ImGui::SetNextItemWidth(150);
+                std::string channel_name = (export_channel < 0) ? "Mix all" : "Channel " + std::to_string(export_channel + 1);
+                if (ImGui::BeginCombo("Export channel", channel_name.c_str())) {
+                    if (ImGui::Selectable("Mix all", export_channel < 0))
+                        export_channel = -1;
+                    for (int c = 0; c < channels; ++c) {
+                        if (ImGui::Selectable(("Channel " + std::to_string(c + 1)).c_str(), export_channel == c))
+                            export_channel = c;
+                    }
+                    ImGui::EndCombo();
+                }
+                ImGui::SameLine();
+                if (ImGui::Checkbox("Stereo Preview", &stereo_preview) && preview_stream && !preview_stream->get_finished())
+                    start_preview();
+            }
 
             // Zoom controls
             ImGui::Checkbox("Zoom", &zoom_enabled);
@@ -263,7 +327,7 @@ void PCM_Tool_Window::display()
                 ImGui::SameLine();
                 if (ImGui::Button("Zoom Out")) {
                     zoom_window_samples = (int)(zoom_window_samples * 2.0f);
-                    if (zoom_window_samples > (int)pcm_data.size()) zoom_window_samples = (int)pcm_data.size();
+                    if (zoom_window_samples > (int)get_frame_count()) zoom_window_samples = (int)get_frame_count();
                 }
                 ImGui::SameLine();
                 if (ImGui::Button("Reset")) {
@@ -300,11 +364,11 @@ void PCM_Tool_Window::display()
             
             // Calculate zoom window if enabled
             int zoom_start_sample = 0;
-            int zoom_end_sample = (int)pcm_data.size();
+            int zoom_end_sample = (int)get_frame_count();
             int zoom_center_sample = 0;
-            std::vector<short> zoom_data;
+            int zoom_length = 0;
             
-            if (zoom_enabled && pcm_data.size() > 0) {
+            if (zoom_enabled && !pcm_data.empty()) {
                 // Determine center point based on selected marker
                 if (zoom_point == 0) {
                     zoom_center_sample = start_point;
@@ -322,47 +386,43 @@ void PCM_Tool_Window::display()
                     zoom_end_sample += -zoom_start_sample;
                     zoom_start_sample = 0;
                 }
-                if (zoom_end_sample > (int)pcm_data.size()) {
-                    zoom_start_sample -= (zoom_end_sample - (int)pcm_data.size());
-                    zoom_end_sample = (int)pcm_data.size();
+                if (zoom_end_sample > (int)get_frame_count()) {
+                    zoom_start_sample -= (zoom_end_sample - (int)get_frame_count());
+                    zoom_end_sample = (int)get_frame_count();
                     if (zoom_start_sample < 0) zoom_start_sample = 0;
                 }
                 
-                // Extract zoom window data
-                zoom_data.clear();
-                for (int i = zoom_start_sample; i < zoom_end_sample; ++i) {
-                    if (i >= 0 && i < (int)pcm_data.size()) {
-                        zoom_data.push_back(pcm_data[i]);
-                    }
-                }
+                zoom_length = zoom_end_sample - zoom_start_sample;
             }
+            bool zoomed = zoom_enabled && zoom_length > 0;
             
             // Draw waveform inside the box (zoomed or full view)
             ImVec2 plot_size = ImVec2(plot_width - margin_x * 2.0f, plot_height);
-            if (zoom_enabled && !zoom_data.empty()) {
-                // Draw zoomed waveform
-                ImGui::PlotLines("##Waveform", WaveformGetter, (void*)&zoom_data, (int)zoom_data.size(), 0, NULL, -1.0f, 1.0f, plot_size);
+            ImVec2 wave_min = ImGui::GetCursorScreenPos();
+            ImVec2 wave_max = ImVec2(wave_min.x + plot_size.x, wave_min.y + plot_size.y);
+            if (zoomed) {
+                draw_waveform(draw_list, wave_min, wave_max, zoom_start_sample, zoom_end_sample);
             } else {
-                // Draw full waveform
-                ImGui::PlotLines("##Waveform", WaveformGetter, (void*)&pcm_data, (int)pcm_data.size(), 0, NULL, -1.0f, 1.0f, plot_size);
+                draw_waveform(draw_list, wave_min, wave_max, 0, (int)get_frame_count());
             }
+            ImGui::Dummy(plot_size);
             
             // Interaction logic for drag tabs
             bool selection_changed = false;
 
-            if (pcm_data.size() > 0)
+            if (!pcm_data.empty())
             {
                 float width = plot_max.x - plot_min.x;
                 float x_step;
                 float count;
                 
-                if (zoom_enabled && !zoom_data.empty()) {
+                if (zoomed) {
                     // In zoom mode, map zoom window samples to display width
-                    count = (float)(zoom_data.size() > 1 ? zoom_data.size() : 1);
+                    count = (float)(zoom_length > 1 ? zoom_length : 1);
                     x_step = width / count;
                 } else {
                     // Normal mode: map all samples to display width
-                    count = (float)(pcm_data.size() > 1 ? pcm_data.size() : 1);
+                    count = (float)(get_frame_count() > 1 ? get_frame_count() : 1);
                     x_step = width / count;
                 }
                 
@@ -375,21 +435,21 @@ void PCM_Tool_Window::display()
                 // Helper to draw and handle tab interaction
                 auto handle_tab = [&](int* point, bool is_top, ImU32 color, const char* id) {
                     if (*point < 0) *point = 0;
-                    if (*point > (int)pcm_data.size()) *point = (int)pcm_data.size();
+                    if (*point > (int)get_frame_count()) *point = (int)get_frame_count();
                     
                     // Map sample index to X position within the box bounds
                     float x;
-                    if (zoom_enabled && !zoom_data.empty()) {
+                    if (zoomed) {
                         // In zoom mode: map point relative to zoom window
                         int point_in_zoom = *point - zoom_start_sample;
-                        if (zoom_data.size() > 1) {
+                        if (zoom_length > 1) {
                             x = plot_min.x + point_in_zoom * x_step;
                         } else {
                             x = plot_min.x + width * 0.5f;
                         }
                     } else {
                         // Normal mode: map point to full range
-                        if (pcm_data.size() > 1) {
+                        if (get_frame_count() > 1) {
                             x = plot_min.x + (*point) * x_step;
                         } else {
                             // Special case: only one sample, center it
@@ -421,7 +481,7 @@ void PCM_Tool_Window::display()
                             *point += delta_samples;
                             // Clamp again
                             if (*point < 0) *point = 0;
-                            if (*point > (int)pcm_data.size()) *point = (int)pcm_data.size();
+                            if (*point > (int)get_frame_count()) *point = (int)get_frame_count();
                             selection_changed = true;
                         }
                     }
@@ -439,13 +499,16 @@ void PCM_Tool_Window::display()
                 handle_tab(&end_point, false, IM_COL32(255, 0, 0, 255), end_tab_id.c_str());
                 
                 // Draw playback position marker (Blue) if previewing
-                bool is_playing = (preview_stream && !preview_stream->get_finished());
-                if (is_playing && current_playback_position >= 0) {
+                Stream_Status::Snapshot preview_status = {};
+                if (preview_stream)
+                    preview_status = preview_stream->get_status()->read();
+                if (preview_status.state == Stream_Status::PLAYING) {
+                    int playback_position = (int)preview_status.position;
                     float x;
-                    if (zoom_enabled && !zoom_data.empty()) {
+                    if (zoomed) {
                         // In zoom mode: map position relative to zoom window
-                        int pos_in_zoom = current_playback_position - zoom_start_sample;
-                        if (zoom_data.size() > 1 && pos_in_zoom >= 0 && pos_in_zoom < (int)zoom_data.size()) {
+                        int pos_in_zoom = playback_position - zoom_start_sample;
+                        if (zoom_length > 1 && pos_in_zoom >= 0 && pos_in_zoom < (int)zoom_length) {
                             x = plot_min.x + pos_in_zoom * x_step;
                         } else {
                             // Position is outside zoom window, don't draw
@@ -453,8 +516,8 @@ void PCM_Tool_Window::display()
                         }
                     } else {
                         // Normal mode
-                        if (pcm_data.size() > 1) {
-                            x = plot_min.x + current_playback_position * x_step;
+                        if (get_frame_count() > 1) {
+                            x = plot_min.x + playback_position * x_step;
                         } else {
                             x = plot_min.x + width * 0.5f;
                         }
@@ -474,7 +537,7 @@ void PCM_Tool_Window::display()
             ImGui::SetCursorPosY(ImGui::GetCursorPosY() + margin_y);
             
             // Sliders for Start/End
-            int max_sample = (int)pcm_data.size();
+            int max_sample = (int)get_frame_count();
             if (end_point > max_sample) end_point = max_sample;
             if (start_point >= end_point) start_point = end_point - 1;
 
@@ -497,9 +560,32 @@ void PCM_Tool_Window::display()
                 else
                     start_preview();
             }
+            if (is_playing)
+            {
+                // Output level of the preview, after gain
+                Stream_Status::Snapshot levels = preview_stream->get_status()->read();
+                float peak = std::max(levels.peak_left, levels.peak_right) / 32767.0f;
+                ImGui::SameLine();
+                ImGui::ProgressBar(peak, ImVec2(100, 0), "");
+            }
 
             ImGui::Separator();
+            ImGui::Checkbox("8-bit (MDSDRV native)", &native_format);
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("Save 8-bit samples at the driver rate, so they are used as is when exporting the project.");
+            ImGui::SameLine();
             ImGui::Checkbox("Double Speed", &double_speed);
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(150);
+            if (ImGui::BeginCombo("Resampling", Resampler::get_quality_name((Resampler::Quality)resample_quality)))
+            {
+                for (int i = 0; i < Resampler::QUALITY_COUNT; i++)
+                {
+                    if (ImGui::Selectable(Resampler::get_quality_name((Resampler::Quality)i), resample_quality == i))
+                        resample_quality = i;
+                }
+                ImGui::EndCombo();
+            }
             
             ImGui::Separator();
             ImGui::Checkbox("Enable Slicing", &slice_enabled);
@@ -513,7 +599,8 @@ void PCM_Tool_Window::display()
             }
             
             ImGui::Separator();
-            bool save_clicked = ImGui::Button("Export (17.5kHz Mono s16le)...");
+            std::string export_label = "Export (" + get_export_format() + ")...###export";
+            bool save_clicked = ImGui::Button(export_label.c_str());
             if (save_clicked)
             {
                 stop_preview(); // Stop any playing preview before exporting
@@ -629,234 +716,29 @@ void PCM_Tool_Window::display()
 
 void PCM_Tool_Window::load_file(const char* filename)
 {
-    // Variables for MP3 conversion (need to be outside try block for cleanup)
-    std::string filepath = filename;
-    std::string temp_wav;
-    bool is_mp3 = false;
-    
     try {
-        // Check if file is MP3 and convert to WAV if needed
-        
-        // Check file extension
-        size_t dot_pos = filepath.find_last_of('.');
-        if (dot_pos != std::string::npos) {
-            std::string ext = filepath.substr(dot_pos + 1);
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-            if (ext == "mp3") {
-                is_mp3 = true;
-            }
-        }
-        
-        // If MP3, convert to temporary WAV file
-        if (is_mp3) {
-            // Try to use ffmpeg to convert MP3 to WAV
-            temp_wav = filepath + ".temp.wav";
-            std::stringstream cmd;
-            cmd << "ffmpeg -i \"" << filepath << "\" -f wav -acodec pcm_s16le -ar 44100 -ac 2 -y \"" << temp_wav << "\" 2>&1";
-            
-            int result = system(cmd.str().c_str());
-            if (result != 0) {
-                // Try with sox as fallback
-                temp_wav = filepath + ".temp.wav";
-                cmd.str("");
-                cmd << "sox \"" << filepath << "\" -r 44100 -c 2 -b 16 \"" << temp_wav << "\" 2>&1";
-                result = system(cmd.str().c_str());
-                if (result != 0) {
-                    status_message = "MP3 conversion failed. Please install ffmpeg or sox.";
-                    return;
-                }
-            }
-            filepath = temp_wav;
-        }
-        
-        // Simple WAV file reader (since we can't access Wave_File private members)
-        std::ifstream file(filepath, std::ios::binary);
-        if (!file) {
-            status_message = "Failed to open audio file";
-            if (is_mp3 && !temp_wav.empty()) {
-                // Clean up temp file
-                remove(temp_wav.c_str());
-            }
-            return;
-        }
-
-        // Read RIFF header
-        char riff[4];
-        file.read(riff, 4);
-        if (memcmp(riff, "RIFF", 4) != 0) {
-            status_message = "Not a valid WAV file (RIFF header missing)";
-            if (is_mp3 && !temp_wav.empty()) {
-                remove(temp_wav.c_str());
-            }
-            return;
-        }
-
-        uint32_t file_size;
-        file.read((char*)&file_size, 4);
-
-        char wave[4];
-        file.read(wave, 4);
-        if (memcmp(wave, "WAVE", 4) != 0) {
-            status_message = "Not a valid WAV file (WAVE header missing)";
-            if (is_mp3 && !temp_wav.empty()) {
-                remove(temp_wav.c_str());
-            }
-            return;
-        }
-
-        // Read chunks
-        uint16_t num_channels = 0;
-        uint32_t sample_rate_val = 0;
-        uint16_t bits_per_sample = 0;
-        uint16_t audio_format = 0;
-        std::vector<std::vector<int16_t>> channel_data;
-        bool found_fmt = false;
-        bool found_data = false;
-
-        while (file && !found_data) {
-            char chunk_id[4];
-            uint32_t chunk_size;
-            file.read(chunk_id, 4);
-            if (file.gcount() != 4) break;
-            file.read((char*)&chunk_size, 4);
-            if (file.gcount() != 4) break;
-
-            if (memcmp(chunk_id, "fmt ", 4) == 0) {
-                file.read((char*)&audio_format, 2);
-                file.read((char*)&num_channels, 2);
-                file.read((char*)&sample_rate_val, 4);
-                uint32_t byte_rate;
-                file.read((char*)&byte_rate, 4);
-                uint16_t block_align;
-                file.read((char*)&block_align, 2);
-                file.read((char*)&bits_per_sample, 2);
-                
-                // Skip any extra format data
-                if (chunk_size > 16) {
-                    file.seekg(chunk_size - 16, std::ios::cur);
-                }
-                found_fmt = true;
-            }
-            else if (memcmp(chunk_id, "data", 4) == 0) {
-                if (!found_fmt || num_channels == 0) {
-                    status_message = "Invalid WAV format (missing format info)";
-                    if (is_mp3 && !temp_wav.empty()) {
-                        remove(temp_wav.c_str());
-                    }
-                    return;
-                }
-
-                // Only support PCM (format 1) for now
-                if (audio_format != 1) {
-                    status_message = "Unsupported audio format (only PCM supported)";
-                    if (is_mp3 && !temp_wav.empty()) {
-                        remove(temp_wav.c_str());
-                    }
-                    return;
-                }
-
-                channel_data.resize(num_channels);
-                size_t bytes_per_sample = bits_per_sample / 8;
-                size_t samples = chunk_size / (num_channels * bytes_per_sample);
-                
-                // Read and convert samples based on bit depth
-                for (size_t i = 0; i < samples; ++i) {
-                    for (int ch = 0; ch < num_channels; ++ch) {
-                        int32_t sample_value = 0;
-                        
-                        if (bits_per_sample == 8) {
-                            uint8_t sample_u8;
-                            file.read((char*)&sample_u8, 1);
-                            // Convert unsigned 8-bit to signed 16-bit
-                            sample_value = ((int32_t)sample_u8 - 128) << 8;
-                        }
-                        else if (bits_per_sample == 16) {
-                            int16_t sample_s16;
-                            file.read((char*)&sample_s16, 2);
-                            sample_value = (int32_t)sample_s16;
-                        }
-                        else if (bits_per_sample == 24) {
-                            // Read 24-bit as 3 bytes (little-endian)
-                            uint8_t bytes[3];
-                            file.read((char*)bytes, 3);
-                            // Sign extend to 32-bit
-                            int32_t sample_24 = (int32_t)(bytes[0] | (bytes[1] << 8) | (bytes[2] << 16));
-                            if (sample_24 & 0x800000) sample_24 |= 0xFF000000; // Sign extend
-                            sample_value = sample_24 >> 8; // Convert to 16-bit range
-                        }
-                        else if (bits_per_sample == 32) {
-                            int32_t sample_s32;
-                            file.read((char*)&sample_s32, 4);
-                            // Convert 32-bit to 16-bit range
-                            sample_value = sample_s32 >> 16;
-                        }
-                        else {
-                            status_message = "Unsupported bit depth: " + std::to_string(bits_per_sample);
-                            if (is_mp3 && !temp_wav.empty()) {
-                                remove(temp_wav.c_str());
-                            }
-                            return;
-                        }
-                        
-                        // Clamp to 16-bit range
-                        if (sample_value > 32767) sample_value = 32767;
-                        if (sample_value < -32768) sample_value = -32768;
-                        
-                        channel_data[ch].push_back((int16_t)sample_value);
-                    }
-                }
-                found_data = true;
-            }
-            else {
-                // Skip unknown chunks
-                if (chunk_size % 2 == 1) chunk_size++; // Align to word boundary
-                file.seekg(chunk_size, std::ios::cur);
-            }
-        }
+        Wave_Data wave = load_audio_file(filename);
 
-        if (!found_data || channel_data.empty() || channel_data[0].empty()) {
-            status_message = "No audio data found in WAV file";
-            if (is_mp3 && !temp_wav.empty()) {
-                remove(temp_wav.c_str());
-            }
-            return;
-        }
+        stop_preview(); // Stop any existing preview
 
-        sample_rate = sample_rate_val;
-        channels = num_channels;
-        size_t samples = channel_data[0].size();
-
-        // Convert to mono for display and processing
-        pcm_data.resize(samples);
-        for(size_t i = 0; i < samples; ++i) {
-            int32_t sum = 0;
-            for(int c = 0; c < channels; ++c) {
-                if (i < channel_data[c].size())
-                    sum += channel_data[c][i];
-            }
-            pcm_data[i] = (short)(sum / channels);
-        }
+        // All channels are kept, they are only mixed down on export
+        sample_rate = wave.sample_rate;
+        channels = wave.channels;
+        size_t frames = wave.get_frames();
+        wave.samples.resize(frames * channels);
+        pcm_data.assign(std::move(wave.samples));
+        waveform.build(pcm_data.share(), channels);
+        export_channel = -1;
 
         start_point = 0;
-        end_point = (int)samples;
-        
-        stop_preview(); // Stop any existing preview
+        end_point = (int)frames;
 
         status_message = "Loaded " + std::string(filename);
         current_filename = filename;
         strncpy(input_path, filename, sizeof(input_path)-1);
         
-        // Clean up temporary WAV file if we converted from MP3
-        if (is_mp3 && !temp_wav.empty()) {
-            remove(temp_wav.c_str());
-        }
-        
     } catch (std::exception& e) {
         status_message = "Error loading file: " + std::string(e.what());
-        // Clean up temporary file on error
-        if (is_mp3 && !temp_wav.empty()) {
-            remove(temp_wav.c_str());
-        }
     }
 }
 
@@ -871,16 +753,23 @@ void PCM_Tool_Window::start_preview()
     
     if (pcm_data.empty()) return;
     
-    // Reset playback position
-    current_playback_position = start_point;
-    
     // Create new stream
-    // We copy the current pcm_data state to the stream to be safe
+    // The stream shares the sample data. The buffer is never changed, edits replace it
+    // Preview either all channels in stereo or what will be exported
+    Mix_Matrix mix = Mix_Matrix::downmix(channels, 2);
+    if (!stereo_preview) {
+        Mix_Matrix export_mix = get_export_matrix();
+        for (int c = 0; c < channels; ++c) {
+            mix.set(0, c, export_mix.get(0, c));
+            mix.set(1, c, export_mix.get(0, c));
+        }
+    }
     std::shared_ptr<PCM_Preview_Stream> stream = std::make_shared<PCM_Preview_Stream>(
-        pcm_data, start_point, end_point, sample_rate, preview_loop, &current_playback_position
+        pcm_data.share(), channels, mix, start_point, end_point, sample_rate, preview_loop
     );
     
     preview_stream = stream;
+    preview_stream->set_bus(Audio_Stream::BUS_PREVIEW);
     Audio_Manager::get().add_stream(preview_stream);
 }
 
@@ -891,98 +780,76 @@ void PCM_Tool_Window::stop_preview()
         preview_stream->set_finished(true);
         preview_stream.reset();
     }
-    current_playback_position = -1; // Reset position when stopped
 }
 
-void PCM_Tool_Window::resample_and_save(const char* filename)
+//! Extract the selection and resample it to the export rate.
+/*!
+ *  With double speed enabled, the selection is resampled to half the
+ *  export rate instead, so that the anti-aliasing filter also covers the
+ *  speed change.
+ *
+ *  Multichannel data is mixed to mono first, using the export channel
+ *  setting.
+ */
+bool PCM_Tool_Window::resample_selection(int target_rate, std::vector<short>& output)
 {
-    if (pcm_data.empty()) return;
-
-    int target_rate = 17500;
-    
-    // We already have mono data in pcm_data
-    // 1. Extract selection
     if (start_point < 0) start_point = 0;
-    if (end_point > (int)pcm_data.size()) end_point = (int)pcm_data.size();
+    if (end_point > (int)get_frame_count()) end_point = (int)get_frame_count();
     if (start_point >= end_point) {
         status_message = "Invalid selection range";
-        return;
+        return false;
     }
 
-    std::vector<short> selection;
-    selection.reserve(end_point - start_point);
-    for(int i = start_point; i < end_point; ++i) {
-        selection.push_back(pcm_data[i]);
-    }
+    if (double_speed)
+        target_rate /= 2;
 
-    // 2. Resample
-    std::vector<short> resampled;
-    if (sample_rate == target_rate) {
-        resampled = selection;
-    } else {
-        double ratio = (double)sample_rate / (double)target_rate;
-        int new_length = (int)(selection.size() / ratio);
-        resampled.resize(new_length);
-        
-        for(int i = 0; i < new_length; ++i) {
-            double src_idx = i * ratio;
-            int idx0 = (int)src_idx;
-            int idx1 = idx0 + 1;
-            float frac = (float)(src_idx - idx0);
-            
-            if (idx1 >= (int)selection.size()) idx1 = idx0;
-            
-            float s0 = selection[idx0];
-            float s1 = selection[idx1];
-            resampled[i] = (short)(s0 + (s1 - s0) * frac);
-        }
+    size_t frames = end_point - start_point;
+    const int16_t* selection = pcm_data.data() + (size_t)start_point * channels;
+    std::vector<int16_t> mono;
+    if (channels > 1) {
+        mono.resize(frames);
+        get_export_matrix().process(selection, mono.data(), frames);
+        selection = mono.data();
     }
 
-    // 3. Apply speed doubling if enabled (skip every other sample)
-    if (double_speed) {
-        std::vector<short> speed_doubled;
-        speed_doubled.reserve(resampled.size() / 2);
-        for (size_t i = 0; i < resampled.size(); i += 2) {
-            speed_doubled.push_back(resampled[i]);
-        }
-        resampled = speed_doubled;
-    }
+    Resampler resampler(sample_rate, target_rate, (Resampler::Quality)resample_quality);
+    output = resampler.process(selection, frames);
+    return true;
+}
 
-    // 4. Save
-    std::ofstream out(filename, std::ios::binary);
-    if (out) {
-        // Write WAV Header
-        uint32_t dataSize = (uint32_t)resampled.size() * sizeof(short);
-        uint32_t fileSize = dataSize + 36;
-        
-        out.write("RIFF", 4);
-        out.write((const char*)&fileSize, 4);
-        out.write("WAVE", 4);
-        out.write("fmt ", 4);
-        
-        uint32_t fmtSize = 16;
-        uint16_t audioFormat = 1; // PCM
-        uint16_t numChannels = 1;
-        uint32_t sampleRate = 17500;
-        uint32_t byteRate = sampleRate * numChannels * sizeof(short);
-        uint16_t blockAlign = numChannels * sizeof(short);
-        uint16_t bitsPerSample = 16;
-        
-        out.write((const char*)&fmtSize, 4);
-        out.write((const char*)&audioFormat, 2);
-        out.write((const char*)&numChannels, 2);
-        out.write((const char*)&sampleRate, 4);
-        out.write((const char*)&byteRate, 4);
-        out.write((const char*)&blockAlign, 2);
-        out.write((const char*)&bitsPerSample, 2);
-        
-        out.write("data", 4);
-        out.write((const char*)&dataSize, 4);
-        
-        // Write Data
-        out.write((char*)resampled.data(), dataSize);
+//! Get the matrix used to mix the data to mono on export.
+Mix_Matrix PCM_Tool_Window::get_export_matrix() const
+{
+    if (export_channel >= 0 && export_channel < channels)
+        return Mix_Matrix::select(channels, export_channel);
+    return Mix_Matrix::downmix(channels, 1);
+}
+
+//! Describe the format written on export, e.g. "17.5kHz Mono s16le".
+std::string PCM_Tool_Window::get_export_format() const
+{
+    int rate = double_speed ? export_rate / 2 : export_rate;
+    std::string channel_name = "Mono";
+    if (channels > 1)
+        channel_name = (export_channel >= 0 && export_channel < channels)
+            ? "Mono from Ch " + std::to_string(export_channel + 1)
+            : "Mono mix";
+    return stringf("%gkHz %s %s", rate / 1000.0, channel_name.c_str(), native_format ? "u8" : "s16le");
+}
+
+void PCM_Tool_Window::resample_and_save(const char* filename)
+{
+    if (pcm_data.empty()) return;
+
+    std::vector<short> resampled;
+    if (!resample_selection(export_rate, resampled))
+        return;
+
+    // Save
+    try {
+        save_wave_file(filename, resampled.data(), resampled.size(), export_rate, 1, native_format ? 8 : 16);
         status_message = "Exported " + std::to_string(resampled.size()) + " samples to " + std::string(filename);
-    } else {
+    } catch (std::exception& e) {
         status_message = "Failed to write output file";
     }
 }
@@ -995,56 +862,11 @@ void PCM_Tool_Window::resample_and_save_slices(const char* base_filename)
         return;
     }
 
-    int target_rate = 17500;
-    
-    // 1. Extract selection
-    if (start_point < 0) start_point = 0;
-    if (end_point > (int)pcm_data.size()) end_point = (int)pcm_data.size();
-    if (start_point >= end_point) {
-        status_message = "Invalid selection range";
-        return;
-    }
-
-    std::vector<short> selection;
-    selection.reserve(end_point - start_point);
-    for(int i = start_point; i < end_point; ++i) {
-        selection.push_back(pcm_data[i]);
-    }
-
-    // 2. Resample
     std::vector<short> resampled;
-    if (sample_rate == target_rate) {
-        resampled = selection;
-    } else {
-        double ratio = (double)sample_rate / (double)target_rate;
-        int new_length = (int)(selection.size() / ratio);
-        resampled.resize(new_length);
-        
-        for(int i = 0; i < new_length; ++i) {
-            double src_idx = i * ratio;
-            int idx0 = (int)src_idx;
-            int idx1 = idx0 + 1;
-            float frac = (float)(src_idx - idx0);
-            
-            if (idx1 >= (int)selection.size()) idx1 = idx0;
-            
-            float s0 = selection[idx0];
-            float s1 = selection[idx1];
-            resampled[i] = (short)(s0 + (s1 - s0) * frac);
-        }
-    }
-
-    // 3. Apply speed doubling if enabled
-    if (double_speed) {
-        std::vector<short> speed_doubled;
-        speed_doubled.reserve(resampled.size() / 2);
-        for (size_t i = 0; i < resampled.size(); i += 2) {
-            speed_doubled.push_back(resampled[i]);
-        }
-        resampled = speed_doubled;
-    }
+    if (!resample_selection(export_rate, resampled))
+        return;
 
-    // 4. Split into slices and save each
+    // Split into slices and save each
     std::string base_path = base_filename;
     // Remove .wav extension if present
     if (base_path.length() >= 4 && base_path.substr(base_path.length() - 4) == ".wav")
@@ -1060,49 +882,13 @@ void PCM_Tool_Window::resample_and_save_slices(const char* base_filename)
         int slice_start = slice * samples_per_slice;
         int slice_end = (slice == num_slices - 1) ? (int)resampled.size() : (slice + 1) * samples_per_slice;
         
-        std::vector<short> slice_data;
-        slice_data.reserve(slice_end - slice_start);
-        for (int i = slice_start; i < slice_end; ++i)
-        {
-            slice_data.push_back(resampled[i]);
-        }
-        
         // Generate filename: base-1.wav, base-2.wav, etc.
         std::string slice_filename = base_path + "-" + std::to_string(slice + 1) + ".wav";
         
-        std::ofstream out(slice_filename, std::ios::binary);
-        if (out) {
-            // Write WAV Header
-            uint32_t dataSize = (uint32_t)slice_data.size() * sizeof(short);
-            uint32_t fileSize = dataSize + 36;
-            
-            out.write("RIFF", 4);
-            out.write((const char*)&fileSize, 4);
-            out.write("WAVE", 4);
-            out.write("fmt ", 4);
-            
-            uint32_t fmtSize = 16;
-            uint16_t audioFormat = 1; // PCM
-            uint16_t numChannels = 1;
-            uint32_t sampleRate = 17500;
-            uint32_t byteRate = sampleRate * numChannels * sizeof(short);
-            uint16_t blockAlign = numChannels * sizeof(short);
-            uint16_t bitsPerSample = 16;
-            
-            out.write((const char*)&fmtSize, 4);
-            out.write((const char*)&audioFormat, 2);
-            out.write((const char*)&numChannels, 2);
-            out.write((const char*)&sampleRate, 4);
-            out.write((const char*)&byteRate, 4);
-            out.write((const char*)&blockAlign, 2);
-            out.write((const char*)&bitsPerSample, 2);
-            
-            out.write("data", 4);
-            out.write((const char*)&dataSize, 4);
-            
-            // Write Data
-            out.write((char*)slice_data.data(), dataSize);
+        try {
+            save_wave_file(slice_filename, resampled.data() + slice_start, slice_end - slice_start, export_rate, 1, native_format ? 8 : 16);
             saved_count++;
+        } catch (std::exception& e) {
         }
     }
     
@@ -1115,14 +901,16 @@ void PCM_Tool_Window::resample_and_save_slices(const char* base_filename)
 
 void PCM_Tool_Window::load_pcm_data(const std::vector<short>& data, int rate, int ch, const std::string& name)
 {
-    pcm_data = data;
+    stop_preview();
+    channels = std::max(ch, 1);
+    pcm_data.assign(Sample_Buffer::Data(data.begin(), data.begin() + data.size() / channels * channels));
+    waveform.build(pcm_data.share(), channels);
     sample_rate = rate;
-    channels = ch;
+    export_channel = -1;
     start_point = 0;
-    end_point = (int)data.size();
+    end_point = (int)get_frame_count();
     current_filename = name.empty() ? "Exported Selection" : name;
     status_message = "Loaded " + current_filename;
-    stop_preview();
 }
 
 void PCM_Tool_Window::export_to_new_window()
@@ -1132,58 +920,13 @@ void PCM_Tool_Window::export_to_new_window()
         return;
     }
 
-    int target_rate = 17500;
-    
-    // 1. Extract selection
-    if (start_point < 0) start_point = 0;
-    if (end_point > (int)pcm_data.size()) end_point = (int)pcm_data.size();
-    if (start_point >= end_point) {
-        status_message = "Invalid selection range";
-        return;
-    }
-
-    std::vector<short> selection;
-    selection.reserve(end_point - start_point);
-    for(int i = start_point; i < end_point; ++i) {
-        selection.push_back(pcm_data[i]);
-    }
-
-    // 2. Resample
     std::vector<short> resampled;
-    if (sample_rate == target_rate) {
-        resampled = selection;
-    } else {
-        double ratio = (double)sample_rate / (double)target_rate;
-        int new_length = (int)(selection.size() / ratio);
-        resampled.resize(new_length);
-        
-        for(int i = 0; i < new_length; ++i) {
-            double src_idx = i * ratio;
-            int idx0 = (int)src_idx;
-            int idx1 = idx0 + 1;
-            float frac = (float)(src_idx - idx0);
-            
-            if (idx1 >= (int)selection.size()) idx1 = idx0;
-            
-            float s0 = selection[idx0];
-            float s1 = selection[idx1];
-            resampled[i] = (short)(s0 + (s1 - s0) * frac);
-        }
-    }
-
-    // 3. Apply speed doubling if enabled
-    if (double_speed) {
-        std::vector<short> speed_doubled;
-        speed_doubled.reserve(resampled.size() / 2);
-        for (size_t i = 0; i < resampled.size(); i += 2) {
-            speed_doubled.push_back(resampled[i]);
-        }
-        resampled = speed_doubled;
-    }
+    if (!resample_selection(export_rate, resampled))
+        return;
 
-    // 4. Create new window with processed data
+    // Create new window with processed data
     std::string export_name = current_filename.empty() ? "Exported Selection" : current_filename + " (exported)";
-    main_window.create_pcm_tool_window_with_data(resampled, target_rate, 1, export_name);
+    main_window.create_pcm_tool_window_with_data(resampled, export_rate, 1, export_name);
         status_message = "Exported " + std::to_string(resampled.size()) + " samples to new window";
 }
 
@@ -1233,8 +976,8 @@ void PCM_Tool_Window::cleanup()
     stop_preview();
     
     // Clear all PCM data to free RAM
-    pcm_data.clear();
-    pcm_data.shrink_to_fit(); // Release memory
+    pcm_data.clear(); // Released once no preview stream uses it
+    waveform.clear();
     
     // Reset state
     sample_rate = 0;
@@ -4,6 +4,9 @@
 #include "window.h"
 #include "addons/imguifilesystem/imguifilesystem.h"
 #include "audio_manager.h"
+#include "waveform_overview.h"
+#include "sample_buffer.h"
+#include "mix_matrix.h"
 #include <vector>
 #include <string>
 #include <memory>
@@ -20,6 +23,9 @@ public:
 private:
     void load_file(const char* filename);
     void save_file(const char* filename);
+    bool resample_selection(int target_rate, std::vector<short>& output);
+    Mix_Matrix get_export_matrix() const;
+    std::string get_export_format() const;
     void resample_and_save(const char* filename);
     void resample_and_save_slices(const char* base_filename);
     void export_to_new_window();
@@ -28,21 +34,26 @@ private:
     void show_close_warning();
     void cleanup();
 
+    inline size_t get_frame_count() const { return channels ? pcm_data.size() / channels : 0; }
+
     ImGuiFs::Dialog fs;
     bool browse_open;
     bool browse_save;
     char input_path[1024];
 
-    std::vector<short> pcm_data;
+    Sample_Buffer pcm_data; // interleaved
     int sample_rate;
     int channels;
+    int export_channel; // -1 = mix all channels
     int start_point;
     int end_point;
     
     bool preview_loop;
+    bool stereo_preview;
     bool double_speed;
+    bool native_format; // save 8-bit samples
+    int resample_quality;
     std::shared_ptr<Audio_Stream> preview_stream;
-    int current_playback_position; // Current playback position in samples
     
     // Slicing options
     bool slice_enabled;
@@ -62,8 +73,9 @@ private:
     ImVec2 initial_position;
     bool position_set;
     
-    // Waveform visualization helper
-    static float WaveformGetter(void* data, int idx);
+    // Waveform visualization
+    void draw_waveform(ImDrawList* draw_list, const ImVec2& min, const ImVec2& max, int start, int end);
+    Waveform_Overview waveform;
 };
 
 #endif //PCM_TOOL_WINDOW_H
@@ -0,0 +1,206 @@
+#include "resampler.h"
+
+#include <cmath>
+#include <algorithm>
+
+//! Number of filter phases between two input samples.
+/*!
+ *  The filter is linearly interpolated between phases.
+ */
+const int Resampler::phase_count = 256;
+
+//! Filter zero crossings on each side of the center.
+static const int zero_crossings = 16;
+
+//! Cutoff frequency relative to the Nyquist frequency.
+static const double rolloff = 0.9;
+
+//! Kaiser window shape parameter (about 90 dB stopband attenuation).
+static const double kaiser_beta = 9.0;
+
+//! Zeroth order modified Bessel function of the first kind.
+static double bessel_i0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for(int k = 1; k < 32; k++)
+	{
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+		if(term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+static inline int16_t to_int16(float value)
+{
+	return std::lrint(std::min(std::max(value, -32768.0f), 32767.0f));
+}
+
+//! constructs a Resampler
+/*!
+ *  The filter bank for the windowed sinc mode is calculated here, so it
+ *  is a good idea to reuse the Resampler when converting many buffers.
+ */
+Resampler::Resampler(uint32_t input_rate, uint32_t output_rate, Quality quality)
+	: input_rate(input_rate ? input_rate : 1)
+	, output_rate(output_rate ? output_rate : 1)
+	, quality(quality)
+	, taps(0)
+{
+	step = ((uint64_t)this->input_rate << 32) / this->output_rate;
+	if(quality == SINC && input_rate != output_rate)
+		init_sinc();
+}
+
+//! Get the display name of a quality setting.
+const char* Resampler::get_quality_name(Quality quality)
+{
+	switch(quality)
+	{
+		case LINEAR:
+			return "Linear";
+		case CUBIC:
+			return "Cubic";
+		case SINC:
+			return "Windowed sinc";
+		default:
+			return "Unknown";
+	}
+}
+
+//! Calculate the polyphase filter bank.
+void Resampler::init_sinc()
+{
+	// When decimating, the cutoff is lowered and the filter is stretched
+	// by the same amount.
+	double scale = std::min(1.0, (double)output_rate / input_rate) * rolloff;
+	double half_width = zero_crossings / scale;
+
+	taps = ((int)std::ceil(half_width) * 2 + 7) & ~7;
+	int center = taps / 2 - 1;
+	double window_scale = 1.0 / bessel_i0(kaiser_beta);
+
+	coefficients.resize((phase_count + 1) * taps);
+	for(int phase = 0; phase <= phase_count; phase++)
+	{
+		float* coef = &coefficients[phase * taps];
+		double frac = (double)phase / phase_count;
+		double sum = 0.0;
+		for(int k = 0; k < taps; k++)
+		{
+			double t = (k - center) - frac;
+			double x = t / half_width;
+			double value = 0.0;
+			if(std::fabs(x) < 1.0)
+			{
+				double window = bessel_i0(kaiser_beta * std::sqrt(1.0 - x * x)) * window_scale;
+				double arg = M_PI * scale * t;
+				double sinc = (std::fabs(arg) < 1e-9) ? 1.0 : std::sin(arg) / arg;
+				value = sinc * window;
+			}
+			coef[k] = value;
+			sum += value;
+		}
+
+		// Normalize to unity gain at DC
+		for(int k = 0; k < taps; k++)
+			coef[k] /= sum;
+	}
+}
+
+//! Calculate one output sample with the windowed sinc filter.
+/*!
+ *  input must be padded with taps zero samples before and after the data.
+ *
+ *  The dot products are accumulated in eight independent lanes so that the
+ *  compiler can map them to vector registers without changing the order of
+ *  floating point operations.
+ */
+inline float Resampler::filter_sinc(const float* input, uint64_t position) const
+{
+	uint32_t frac = position & 0xffffffff;
+	float phase = frac * ((float)phase_count / 4294967296.0f);
+	int phase_index = std::min((int)phase, phase_count - 1);
+	float phase_frac = phase - phase_index;
+
+	const float* coef0 = &coefficients[phase_index * taps];
+	const float* coef1 = coef0 + taps;
+	const float* data = input + taps + (position >> 32) - (taps / 2 - 1);
+
+	float acc0[8] = {};
+	float acc1[8] = {};
+	for(int k = 0; k < taps; k += 8)
+	{
+		for(int j = 0; j < 8; j++)
+		{
+			acc0[j] += coef0[k + j] * data[k + j];
+			acc1[j] += coef1[k + j] * data[k + j];
+		}
+	}
+
+	float sum0 = 0.0f;
+	float sum1 = 0.0f;
+	for(int j = 0; j < 8; j++)
+	{
+		sum0 += acc0[j];
+		sum1 += acc1[j];
+	}
+	return sum0 + (sum1 - sum0) * phase_frac;
+}
+
+//! Convert the sample rate of a buffer.
+/*!
+ *  \return the converted data, length * output_rate / input_rate samples long.
+ */
+std::vector<int16_t> Resampler::process(const int16_t* input, size_t length) const
+{
+	if(input_rate == output_rate)
+		return std::vector<int16_t>(input, input + length);
+
+	size_t output_length = (uint64_t)length * output_rate / input_rate;
+	std::vector<int16_t> output(output_length);
+	if(!length)
+		return output;
+
+	uint64_t position = 0;
+	switch(quality)
+	{
+		case LINEAR:
+			for(size_t i = 0; i < output_length; i++, position += step)
+			{
+				size_t index = position >> 32;
+				float frac = (position & 0xffffffff) / 4294967296.0f;
+				float s0 = input[index];
+				float s1 = input[std::min(index + 1, length - 1)];
+				output[i] = to_int16(s0 + (s1 - s0) * frac);
+			}
+			break;
+		case CUBIC:
+			for(size_t i = 0; i < output_length; i++, position += step)
+			{
+				size_t index = position >> 32;
+				float t = (position & 0xffffffff) / 4294967296.0f;
+				float s0 = input[index ? index - 1 : 0];
+				float s1 = input[index];
+				float s2 = input[std::min(index + 1, length - 1)];
+				float s3 = input[std::min(index + 2, length - 1)];
+				// Catmull-Rom spline
+				float a = -0.5f * s0 + 1.5f * s1 - 1.5f * s2 + 0.5f * s3;
+				float b = s0 - 2.5f * s1 + 2.0f * s2 - 0.5f * s3;
+				float c = -0.5f * s0 + 0.5f * s2;
+				output[i] = to_int16(((a * t + b) * t + c) * t + s1);
+			}
+			break;
+		default:
+		{
+			std::vector<float> padded(length + taps * 2, 0.0f);
+			std::copy(input, input + length, padded.begin() + taps);
+			for(size_t i = 0; i < output_length; i++, position += step)
+				output[i] = to_int16(filter_sinc(padded.data(), position));
+			break;
+		}
+	}
+	return output;
+}
@@ -0,0 +1,51 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//! Sample rate converter for mono PCM data
+/*!
+ *  The windowed-sinc mode uses a polyphase filter bank with its cutoff set
+ *  below the lower of the two Nyquist frequencies, so decimation does not
+ *  alias. Linear and cubic interpolation are cheaper, but do no filtering.
+ *
+ *  A Resampler can be reused for any number of buffers with the same rates.
+ */
+class Resampler
+{
+	public:
+		enum Quality
+		{
+			LINEAR = 0,
+			CUBIC = 1,
+			SINC = 2,
+			QUALITY_COUNT
+		};
+
+		Resampler(uint32_t input_rate, uint32_t output_rate, Quality quality = SINC);
+
+		std::vector<int16_t> process(const int16_t* input, size_t length) const;
+
+		inline Quality get_quality() const { return quality; }
+
+		static const char* get_quality_name(Quality quality);
+
+	private:
+		void init_sinc();
+
+		float filter_sinc(const float* input, uint64_t position) const;
+
+		uint32_t input_rate;
+		uint32_t output_rate;
+		Quality quality;
+		uint64_t step;				// input samples per output sample, 32.32 fixed point
+
+		// windowed sinc filter bank
+		const static int phase_count;
+		int taps;					// taps per phase, a multiple of 8
+		std::vector<float> coefficients;	// (phase_count + 1) * taps
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+
+//! Lock-free single producer, single consumer ring buffer
+/*!
+ *  write() may only be called from one thread and read() from one other
+ *  thread. The size is rounded up to a power of two.
+ *
+ *  resize() and clear() are not thread safe and must only be called while
+ *  neither side is accessing the buffer.
+ */
+template<typename T>
+class Ring_Buffer
+{
+	public:
+		Ring_Buffer(size_t min_size = 0)
+			: buffer()
+			, mask(0)
+			, read_pos(0)
+			, write_pos(0)
+		{
+			resize(min_size);
+		}
+
+		void resize(size_t min_size)
+		{
+			size_t size = 1;
+			while(size < min_size)
+				size <<= 1;
+			buffer.assign(size, T());
+			mask = size - 1;
+			clear();
+		}
+
+		void clear()
+		{
+			read_pos.store(0, std::memory_order_relaxed);
+			write_pos.store(0, std::memory_order_relaxed);
+		}
+
+		//! Get the number of elements that the buffer can hold.
+		inline size_t capacity() const
+		{
+			return buffer.size();
+		}
+
+		//! Get the number of elements available for reading.
+		inline size_t size() const
+		{
+			return write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_acquire);
+		}
+
+		//! Get the number of elements that can be written.
+		inline size_t space() const
+		{
+			return capacity() - size();
+		}
+
+		//! Write up to count elements. Returns the number of elements written.
+		size_t write(const T* data, size_t count)
+		{
+			size_t wpos = write_pos.load(std::memory_order_relaxed);
+			size_t rpos = read_pos.load(std::memory_order_acquire);
+			count = std::min(count, capacity() - (wpos - rpos));
+
+			size_t offset = wpos & mask;
+			size_t first = std::min(count, capacity() - offset);
+			std::copy_n(data, first, buffer.begin() + offset);
+			std::copy_n(data + first, count - first, buffer.begin());
+
+			write_pos.store(wpos + count, std::memory_order_release);
+			return count;
+		}
+
+		//! Read up to count elements. Returns the number of elements read.
+		size_t read(T* data, size_t count)
+		{
+			size_t rpos = read_pos.load(std::memory_order_relaxed);
+			size_t wpos = write_pos.load(std::memory_order_acquire);
+			count = std::min(count, wpos - rpos);
+
+			size_t offset = rpos & mask;
+			size_t first = std::min(count, capacity() - offset);
+			std::copy_n(buffer.begin() + offset, first, data);
+			std::copy_n(buffer.begin(), count - first, data + first);
+
+			read_pos.store(rpos + count, std::memory_order_release);
+			return count;
+		}
+
+	private:
+		std::vector<T> buffer;
+		size_t mask;
+
+		std::atomic<size_t> read_pos;
+		std::atomic<size_t> write_pos;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef SAMPLE_BUFFER_H
+#define SAMPLE_BUFFER_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+//! Reference counted, immutable sample data
+/*!
+ *  Copies of a Sample_Buffer, and the pointers returned by share(), refer
+ *  to the same data. Audio streams can keep a shared pointer while playing
+ *  without copying the samples.
+ *
+ *  The data is never modified in place. Changes are made by building new
+ *  data and passing it to assign(), so readers holding the old data are
+ *  not affected.
+ */
+class Sample_Buffer
+{
+	public:
+		typedef std::vector<int16_t> Data;
+
+		Sample_Buffer()
+			: buffer(std::make_shared<Data>())
+		{
+		}
+
+		Sample_Buffer(Data&& data)
+			: buffer(std::make_shared<Data>(std::move(data)))
+		{
+		}
+
+		//! Get a pointer to the data for another thread or owner.
+		inline std::shared_ptr<const Data> share() const { return buffer; }
+
+		//! Get the data for reading.
+		inline const Data& get() const { return *buffer; }
+
+		//! Replace the data.
+		void assign(Data&& data)
+		{
+			buffer = std::make_shared<Data>(std::move(data));
+		}
+
+		void clear()
+		{
+			buffer = std::make_shared<Data>();
+		}
+
+		inline size_t size() const { return buffer->size(); }
+		inline bool empty() const { return buffer->empty(); }
+		inline const int16_t* data() const { return buffer->data(); }
+		inline const int16_t& operator[](size_t index) const { return (*buffer)[index]; }
+
+	private:
+		std::shared_ptr<const Data> buffer;
+};
+
+#endif
@@ -14,27 +14,38 @@
 
 const int Song_Manager::max_channels = 16;
 
-// TODO : Use Song to get the correct map for each platform
-const std::map<uint16_t, std::pair<int16_t,uint32_t>> Song_Manager::track_channel_table = {
-	{0, {2, 1<<0}}, // YM2612
-	{1, {2, 1<<1}},
-	{2, {2, 1<<2}},
-	{3, {2, 1<<3}},
-	{4, {2, 1<<4}},
-	{5, {2, (1<<5)|(1<<6)}},
-
-	{6, {0, 1<<0}}, // SN76489
-	{7, {0, 1<<1}},
-	{8, {0, 1<<2}},
-	{9, {0, 1<<3}},
-
-	{10, {2, (1<<5)|(1<<6)}}, // PCM 2,3
-	{11, {2, (1<<5)|(1<<6)}},
-
-	{12, {2, 1<<2}}, // FM3 Dummy
-	{13, {2, 1<<2}},
-	{14, {2, 1<<2}},
-	{15, {2, 1<<2}},
+//! A group of consecutive tracks mapped to channels of one sound chip.
+/*!
+ *  Track n of the group is mapped to the channel mask (mask << (n * shift)).
+ */
+struct Track_Group
+{
+	int16_t chip_id;
+	uint16_t count;
+	uint32_t mask;
+	uint8_t shift;
+};
+
+//! Track layout of a platform.
+struct Platform_Layout
+{
+	const char* name;
+	std::vector<Track_Group> groups;
+};
+
+// Chip IDs match the libvgm device IDs used by Emu_Player.
+static const std::vector<Track_Group> megadrive_layout = {
+	{2, 5, 1<<0, 1},		// YM2612 FM1-5
+	{2, 1, (1<<5)|(1<<6), 0},	// YM2612 FM6 + DAC
+	{0, 4, 1<<0, 1},		// SN76489
+	{2, 2, (1<<5)|(1<<6), 0},	// PCM 2,3
+	{2, 4, 1<<2, 0},		// FM3 Dummy
+};
+
+// The first entry is the default layout.
+static const std::vector<Platform_Layout> platform_layouts = {
+	{"megadrive", megadrive_layout},
+	{"mdsdrv", megadrive_layout},
 };
 
 //! constructs a Song_Manager
@@ -44,7 +55,12 @@ Song_Manager::Song_Manager()
 	, job_done(false)
 	, job_successful(false)
 	, song(nullptr)
+	, track_channel_table(generate_channel_table(""))
 	, player(nullptr)
+	, buffered_stream(nullptr)
+	, playback_status(nullptr)
+	, gain(1.0f)
+	, pan(0.0f)
 	, editor_position({-1, -1})
 	, editor_jump_hack(false)
 	, song_pos_at_line(0)
@@ -141,7 +157,21 @@ void Song_Manager::play(uint32_t start_position)
 	Audio_Manager& am = Audio_Manager::get();
 	player = std::make_shared<Emu_Player>(get_song(), start_position);
 	player->set_mute_mask(mute_mask);
-	am.add_stream(std::static_pointer_cast<Audio_Stream>(player));
+
+	// Render ahead of playback in a separate thread if enabled.
+	unsigned int buffer_length = am.get_buffer_length();
+	if(buffer_length)
+	{
+		buffered_stream = std::make_shared<Buffered_Stream>(player, buffer_length);
+		buffered_stream->set_gain(gain, pan);
+		am.add_stream(std::static_pointer_cast<Audio_Stream>(buffered_stream));
+	}
+	else
+	{
+		player->set_gain(gain, pan);
+		am.add_stream(std::static_pointer_cast<Audio_Stream>(player));
+	}
+	playback_status = buffered_stream ? buffered_stream->get_status() : player->get_status();
 }
 
 //! Stop song playback
@@ -151,6 +181,11 @@ void Song_Manager::stop()
 	{
 		player->set_finished(true);
 	}
+	if(buffered_stream.get() != nullptr)
+	{
+		buffered_stream->set_finished(true);
+		buffered_stream.reset();
+	}
 }
 
 //! Get song data
@@ -166,6 +201,22 @@ std::shared_ptr<Emu_Player> Song_Manager::get_player()
 	return player;
 }
 
+//! Get the render-ahead stream of the player, or nullptr if playback is not buffered.
+std::shared_ptr<Buffered_Stream> Song_Manager::get_buffered_stream()
+{
+	return buffered_stream;
+}
+
+//! Get the status of the playing song.
+/*!
+ *  The position is the driver tick count of the audio that is currently
+ *  heard, which lags behind the player when playback is buffered.
+ */
+std::shared_ptr<const Stream_Status> Song_Manager::get_playback_status()
+{
+	return playback_status;
+}
+
 //! Get track info data
 std::shared_ptr<std::map<int,Track_Info>> Song_Manager::get_tracks()
 {
@@ -417,6 +468,7 @@ void Song_Manager::compile_job(std::unique_lock<std::mutex>& lock, std::string b
 	std::shared_ptr<Song> temp_song = nullptr;
 	std::shared_ptr<Track_Map> temp_tracks = nullptr;
 	std::shared_ptr<Line_Map> temp_lines = nullptr;
+	std::shared_ptr<const Channel_Table> temp_channel_table = nullptr;
 	std::string str;
 	std::string message;
 	int line = 0;
@@ -442,6 +494,17 @@ void Song_Manager::compile_job(std::unique_lock<std::mutex>& lock, std::string b
 			line++;
 		}
 
+		// Get the track to channel mapping for muting.
+		std::string platform = "";
+		try
+		{
+			platform = temp_song->get_tag_front("#platform");
+		}
+		catch (std::exception&)
+		{
+		}
+		temp_channel_table = generate_channel_table(platform);
+
 		// Generate track note lists.
 		for(auto it = temp_song->get_track_map().begin(); it != temp_song->get_track_map().end(); it++)
 		{
@@ -473,13 +536,15 @@ void Song_Manager::compile_job(std::unique_lock<std::mutex>& lock, std::string b
 	lines = temp_lines;
 	error_message = message;
 	error_reference = ref;
+	if(temp_channel_table)
+		track_channel_table = temp_channel_table;
 }
 
 //! Convert all tabs to spaces in a string.
 /*!
  *  Currently tabstop is hardcoded to 4 to match the editor.
  */
-std::string Song_Manager::tabs_to_spaces(const std::string& str) const
+std::string Song_Manager::tabs_to_spaces(const std::string& str)
 {
 	const unsigned int tabstop = 4;
 	std::string out = "";
@@ -501,10 +566,38 @@ std::string Song_Manager::tabs_to_spaces(const std::string& str) const
 	return out;
 }
 
+//! Generate the track to channel table for a platform.
+/*!
+ *  Unknown platforms use the default layout.
+ */
+std::shared_ptr<const Song_Manager::Channel_Table> Song_Manager::generate_channel_table(const std::string& platform)
+{
+	const Platform_Layout* layout = &platform_layouts.front();
+	for(auto && i : platform_layouts)
+	{
+		if(platform == i.name)
+			layout = &i;
+	}
+
+	auto table = std::make_shared<Channel_Table>();
+	uint16_t track = 0;
+	for(auto && group : layout->groups)
+	{
+		for(uint16_t i = 0; i < group.count; i++)
+			table->emplace(track++, std::make_pair(group.chip_id, group.mask << (i * group.shift)));
+	}
+	return table;
+}
+
 std::pair<int16_t,uint32_t> Song_Manager::get_channel(uint16_t track) const
 {
-	auto search = track_channel_table.find(track);
-	if(search != track_channel_table.end())
+	std::shared_ptr<const Channel_Table> table;
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		table = track_channel_table;
+	}
+	auto search = table->find(track);
+	if(search != table->end())
 	{
 		return search->second;
 	}
@@ -585,11 +678,31 @@ bool Song_Manager::get_solo(uint16_t track_id) const
 
 void Song_Manager::reset_mute()
 {
-	mute_mask[0x00] = 0;
-	mute_mask[0x02] = 0;
+	std::shared_ptr<const Channel_Table> table;
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		table = track_channel_table;
+	}
+	mute_mask.clear();
+	for(auto && i : *table)
+		mute_mask[i.second.first] = 0;
 	update_mute();
 }
 
+//! Set the output gain and balance of the song.
+/*!
+ *  Applies to the current playback as well as future playback.
+ */
+void Song_Manager::set_gain(float new_gain, float new_pan)
+{
+	gain = new_gain;
+	pan = new_pan;
+	if(buffered_stream)
+		buffered_stream->set_gain(gain, pan);
+	else if(player)
+		player->set_gain(gain, pan);
+}
+
 void Song_Manager::update_mute()
 {
 	if(player)
@@ -15,6 +15,7 @@
 #include "mml_input.h"
 
 #include "audio_manager.h"
+#include "buffered_stream.h"
 #include "emu_player.h"
 
 struct Track_Info;
@@ -32,6 +33,7 @@ class Song_Manager
 		typedef std::map<int, Track_Info> Track_Map;
 		typedef std::map<int, MML_Input::Track_Position_Map> Line_Map;
 		typedef std::set<InputRef*> Ref_Ptr_Set;
+		typedef std::map<uint16_t, std::pair<int16_t, uint32_t>> Channel_Table; // Track to chip ID and channel mask
 
 		typedef struct
 		{
@@ -51,6 +53,8 @@ class Song_Manager
 
 		std::shared_ptr<Song> get_song();
 		std::shared_ptr<Emu_Player> get_player();
+		std::shared_ptr<Buffered_Stream> get_buffered_stream();
+		std::shared_ptr<const Stream_Status> get_playback_status();
 		std::shared_ptr<Track_Map> get_tracks();
 		std::shared_ptr<Line_Map> get_lines();
 		std::string get_error_message();
@@ -82,17 +86,28 @@ class Song_Manager
 
 		void reset_mute();
 
+		void set_gain(float new_gain, float new_pan);
+
+		//! Get the output gain of the song stream.
+		inline float get_gain() const { return gain; }
+
+		//! Get the output balance of the song stream.
+		inline float get_pan() const { return pan; }
+
+		static std::string tabs_to_spaces(const std::string& str);
+
 	private:
 		void worker();
 		void compile_job(std::unique_lock<std::mutex>& lock, std::string buffer, std::string filename);
-		std::string tabs_to_spaces(const std::string& str) const;
 		void update_mute();
 
+		static std::shared_ptr<const Channel_Table> generate_channel_table(const std::string& platform);
+
 		// song status
 		const static int max_channels;
 
 		// worker state
-		std::mutex mutex;
+		mutable std::mutex mutex;
 		std::condition_variable condition_variable;
 		std::unique_ptr<std::thread> worker_ptr;
 
@@ -111,9 +126,14 @@ class Song_Manager
 		std::shared_ptr<Line_Map> lines;
 		std::string error_message;
 		std::shared_ptr<InputRef> error_reference;
+		std::shared_ptr<const Channel_Table> track_channel_table;
 
 		// playback state
 		std::shared_ptr<Emu_Player> player;
+		std::shared_ptr<Buffered_Stream> buffered_stream;
+		std::shared_ptr<const Stream_Status> playback_status;
+		float gain;
+		float pan;
 
 		// editor state
 		Editor_Position editor_position;
@@ -125,7 +145,6 @@ class Song_Manager
 
 		// muting
 		std::map<int16_t, uint32_t> mute_mask; // Chip_id, channel_id
-		const static std::map<uint16_t, std::pair<int16_t, uint32_t>> track_channel_table; // Track to channel ID table
 };
 
 #endif
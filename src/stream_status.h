@@ -0,0 +1,94 @@
+#ifndef STREAM_STATUS_H
+#define STREAM_STATUS_H
+
+#include <atomic>
+#include <cstdint>
+
+//! Lock-free playback status of an Audio_Stream
+/*!
+ *  The audio thread publishes the playback position, peak levels and state
+ *  of a stream once per audio buffer. Any number of threads can read a
+ *  consistent snapshot without locking.
+ *
+ *  This is a sequence lock: publish() makes the sequence counter odd while
+ *  the fields are being written. read() retries if the counter was odd or
+ *  changed while reading. There must only be one writer at a time.
+ *
+ *  The object is reference counted by the stream and its readers, so it
+ *  stays valid even after the stream has been removed.
+ */
+class Stream_Status
+{
+	public:
+		enum State
+		{
+			IDLE = 0,		// not yet mixed
+			PLAYING = 1,
+			FINISHED = 2,	// removed from the mixer
+		};
+
+		struct Snapshot
+		{
+			int64_t position;		// stream specific unit
+			uint16_t peak_left;		// peak level in the last buffer, 0-32767
+			uint16_t peak_right;
+			State state;
+		};
+
+		Stream_Status()
+			: sequence(0)
+			, position(0)
+			, peak_left(0)
+			, peak_right(0)
+			, state(IDLE)
+		{
+		}
+
+		//! Publish a new status. Only call from one thread at a time.
+		void publish(const Snapshot& snapshot)
+		{
+			uint32_t seq = sequence.load(std::memory_order_relaxed);
+			sequence.store(seq + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			position.store(snapshot.position, std::memory_order_relaxed);
+			peak_left.store(snapshot.peak_left, std::memory_order_relaxed);
+			peak_right.store(snapshot.peak_right, std::memory_order_relaxed);
+			state.store(snapshot.state, std::memory_order_relaxed);
+
+			sequence.store(seq + 2, std::memory_order_release);
+		}
+
+		//! Read the last published status.
+		Snapshot read() const
+		{
+			Snapshot snapshot;
+			uint32_t seq;
+			do
+			{
+				seq = sequence.load(std::memory_order_acquire);
+				snapshot.position = position.load(std::memory_order_relaxed);
+				snapshot.peak_left = peak_left.load(std::memory_order_relaxed);
+				snapshot.peak_right = peak_right.load(std::memory_order_relaxed);
+				snapshot.state = state.load(std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_acquire);
+			}
+			while((seq & 1) || seq != sequence.load(std::memory_order_relaxed));
+			return snapshot;
+		}
+
+		//! Get the number of updates published so far.
+		inline uint32_t get_update_count() const
+		{
+			return sequence.load(std::memory_order_acquire) / 2;
+		}
+
+	private:
+		std::atomic<uint32_t> sequence;
+		std::atomic<int64_t> position;
+		std::atomic<uint16_t> peak_left;
+		std::atomic<uint16_t> peak_right;
+		std::atomic<State> state;
+};
+
+#endif
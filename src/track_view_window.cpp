@@ -144,11 +144,14 @@ void Track_View_Window::update_position()
 	y_scale = std::pow(y_scale_log, 2);
 
 	// Get player position
-	auto player =  song_manager->get_player();
-	if(player != nullptr && !player->get_finished())
-		y_player = player->get_driver()->get_player_ticks();
-	else
-		y_player = 0;
+	auto status = song_manager->get_playback_status();
+	y_player = 0;
+	if(status != nullptr)
+	{
+		auto snapshot = status->read();
+		if(snapshot.state == Stream_Status::PLAYING)
+			y_player = snapshot.position;
+	}
 
 	if(y_follow)
 	{
@@ -0,0 +1,63 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <vector>
+#include "../audio_compare.h"
+
+class Audio_Compare_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Audio_Compare_Test);
+	CPPUNIT_TEST(test_equal);
+	CPPUNIT_TEST(test_tolerance);
+	CPPUNIT_TEST(test_first_difference);
+	CPPUNIT_TEST(test_length);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	std::vector<int16_t> make_audio(size_t frames)
+	{
+		std::vector<int16_t> data(frames * 2);
+		for(size_t i = 0; i < data.size(); i++)
+			data[i] = i * 37 - 1000;
+		return data;
+	}
+public:
+	void test_equal()
+	{
+		auto a = make_audio(100);
+		Audio_Difference diff = compare_audio(a.data(), 100, a.data(), 100, 2);
+		CPPUNIT_ASSERT(diff.matches);
+		CPPUNIT_ASSERT_EQUAL(0, diff.max_difference);
+	}
+	void test_tolerance()
+	{
+		auto a = make_audio(100);
+		auto b = a;
+		b[51] += 2;
+		CPPUNIT_ASSERT(!compare_audio(a.data(), 100, b.data(), 100, 2, 1).matches);
+		Audio_Difference diff = compare_audio(a.data(), 100, b.data(), 100, 2, 2);
+		CPPUNIT_ASSERT(diff.matches);
+		CPPUNIT_ASSERT_EQUAL(2, diff.max_difference);
+	}
+	void test_first_difference()
+	{
+		auto a = make_audio(100);
+		auto b = a;
+		b[61] = 5000;
+		b[80] = -5000;
+		Audio_Difference diff = compare_audio(a.data(), 100, b.data(), 100, 2);
+		CPPUNIT_ASSERT(!diff.matches);
+		CPPUNIT_ASSERT_EQUAL((size_t)30, diff.first_frame);
+		CPPUNIT_ASSERT_EQUAL(1, diff.channel);
+		CPPUNIT_ASSERT_EQUAL((int)a[61], diff.expected);
+		CPPUNIT_ASSERT_EQUAL(5000, diff.actual);
+		CPPUNIT_ASSERT_EQUAL((size_t)2, diff.differing_samples);
+	}
+	void test_length()
+	{
+		auto a = make_audio(100);
+		Audio_Difference diff = compare_audio(a.data(), 100, a.data(), 90, 2);
+		CPPUNIT_ASSERT(!diff.matches);
+		CPPUNIT_ASSERT_EQUAL((size_t)90, diff.first_frame);
+		CPPUNIT_ASSERT_EQUAL(-1, diff.channel);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Audio_Compare_Test);
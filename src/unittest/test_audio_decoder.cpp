@@ -0,0 +1,80 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdexcept>
+#include <fstream>
+#include <filesystem>
+#include "../audio_decoder.h"
+#include "../audio_compare.h"
+
+// The fixtures are run from the source directory, like the golden audio test.
+// test_mp3.wav and test_ogg.wav were decoded from the fixtures with libsndfile
+// (mpg123 and libvorbis).
+#define FIXTURE_PATH "src/unittest/audio/"
+
+class Audio_Decoder_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Audio_Decoder_Test);
+	CPPUNIT_TEST(test_wav);
+	CPPUNIT_TEST(test_flac);
+	CPPUNIT_TEST(test_mp3);
+	CPPUNIT_TEST(test_ogg);
+	CPPUNIT_TEST(test_unsupported);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	static void compare_reference(const Wave_Data& wave, const std::string& reference_filename)
+	{
+		Wave_Data reference = load_wave_file(reference_filename);
+		CPPUNIT_ASSERT_EQUAL(reference.sample_rate, wave.sample_rate);
+		CPPUNIT_ASSERT_EQUAL(reference.channels, wave.channels);
+		Audio_Difference diff = compare_audio(reference.samples.data(), reference.get_frames(),
+			wave.samples.data(), wave.get_frames(), wave.channels, 4);
+		CPPUNIT_ASSERT_MESSAGE("Decoded audio differs at frame " + std::to_string(diff.first_frame), diff.matches);
+	}
+public:
+	void test_wav()
+	{
+		std::string filename = (std::filesystem::temp_directory_path() / "mmlgui_test_decoder.wav").string();
+		const int16_t samples[6] = {0, 1000, -1000, 32767, -32768, 5};
+		save_wave_file(filename, samples, 3, 32000, 2);
+
+		Wave_Data wave = load_audio_file(filename);
+		std::filesystem::remove(filename);
+		CPPUNIT_ASSERT_EQUAL((uint32_t)32000, wave.sample_rate);
+		CPPUNIT_ASSERT_EQUAL((uint16_t)2, wave.channels);
+		CPPUNIT_ASSERT(wave.samples == std::vector<int16_t>(samples, samples + 6));
+	}
+	void test_flac()
+	{
+		// Lossless, so the generated pattern must come back exactly
+		Wave_Data wave = load_audio_file(FIXTURE_PATH "test.flac");
+		CPPUNIT_ASSERT_EQUAL((uint32_t)44100, wave.sample_rate);
+		CPPUNIT_ASSERT_EQUAL((uint16_t)2, wave.channels);
+		CPPUNIT_ASSERT_EQUAL((size_t)1024, wave.get_frames());
+		for(int i = 0; i < 1024; i++)
+		{
+			int16_t expected = (i * 37) % 2001 - 1000;
+			CPPUNIT_ASSERT_EQUAL(expected, wave.samples[i * 2]);
+			CPPUNIT_ASSERT_EQUAL((int16_t)-expected, wave.samples[i * 2 + 1]);
+		}
+	}
+	void test_mp3()
+	{
+		Wave_Data wave = load_audio_file(FIXTURE_PATH "test.mp3");
+		CPPUNIT_ASSERT_EQUAL((size_t)20 * 1152, wave.get_frames());
+		compare_reference(wave, FIXTURE_PATH "test_mp3.wav");
+	}
+	void test_ogg()
+	{
+		Wave_Data wave = load_audio_file(FIXTURE_PATH "test.ogg");
+		CPPUNIT_ASSERT_EQUAL((size_t)100 * 128, wave.get_frames());
+		compare_reference(wave, FIXTURE_PATH "test_ogg.wav");
+	}
+	void test_unsupported()
+	{
+		std::string filename = (std::filesystem::temp_directory_path() / "mmlgui_test_decoder.txt").string();
+		std::ofstream(filename) << "not audio";
+		CPPUNIT_ASSERT_THROW(load_audio_file(filename), std::runtime_error);
+		std::filesystem::remove(filename);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Audio_Decoder_Test);
@@ -0,0 +1,32 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../content_hash.h"
+
+class Content_Hash_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Content_Hash_Test);
+	CPPUNIT_TEST(test_hash);
+	CPPUNIT_TEST(test_string);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void test_hash()
+	{
+		// FNV-1a reference values
+		Content_Hash empty;
+		CPPUNIT_ASSERT_EQUAL((uint64_t)0xcbf29ce484222325ULL, empty.get());
+		Content_Hash a;
+		a.add("a", 1);
+		CPPUNIT_ASSERT_EQUAL((uint64_t)0xaf63dc4c8601ec8cULL, a.get());
+		CPPUNIT_ASSERT_EQUAL(std::string("af63dc4c8601ec8c"), a.to_string());
+	}
+	void test_string()
+	{
+		Content_Hash h1, h2;
+		h1.add(std::string("ab"));
+		h1.add(std::string("c"));
+		h2.add(std::string("a"));
+		h2.add(std::string("bc"));
+		CPPUNIT_ASSERT(h1.get() != h2.get());
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Content_Hash_Test);
@@ -0,0 +1,90 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include "../directory_scan.h"
+
+namespace fs = std::filesystem;
+
+class Directory_Scan_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Directory_Scan_Test);
+	CPPUNIT_TEST(test_scan);
+	CPPUNIT_TEST(test_unchanged);
+	CPPUNIT_TEST(test_added_file);
+	CPPUNIT_TEST(test_other_directory);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	fs::path directory;
+
+	void touch(const fs::path& path)
+	{
+		std::ofstream(path).close();
+	}
+	//! Make sure a change is visible even on file systems with coarse timestamps.
+	void age(const fs::path& path)
+	{
+		fs::last_write_time(path, fs::last_write_time(path) - std::chrono::seconds(10));
+	}
+	std::vector<std::string> sorted_names(const Directory_Scan& scan)
+	{
+		std::vector<std::string> names;
+		for(auto&& i : scan.get_files())
+			names.push_back(fs::path(i).filename().string());
+		std::sort(names.begin(), names.end());
+		return names;
+	}
+public:
+	void setUp()
+	{
+		directory = fs::temp_directory_path() / "mmlgui_test_directory_scan";
+		fs::remove_all(directory);
+		fs::create_directories(directory / "sub");
+		touch(directory / "a.mml");
+		touch(directory / "b.txt");
+		touch(directory / "sub" / "c.MDS");
+		age(directory / "sub");
+		age(directory);
+	}
+	void tearDown()
+	{
+		fs::remove_all(directory);
+	}
+	void test_scan()
+	{
+		Directory_Scan scan({".mml", ".mds"});
+		CPPUNIT_ASSERT(scan.update(directory.string()));
+		auto names = sorted_names(scan);
+		CPPUNIT_ASSERT_EQUAL((size_t)2, names.size());
+		CPPUNIT_ASSERT_EQUAL(std::string("a.mml"), names[0]);
+		CPPUNIT_ASSERT_EQUAL(std::string("c.MDS"), names[1]);
+	}
+	void test_unchanged()
+	{
+		Directory_Scan scan({".mml", ".mds"});
+		scan.update(directory.string());
+		CPPUNIT_ASSERT(!scan.update(directory.string()));
+		CPPUNIT_ASSERT_EQUAL((size_t)2, scan.get_files().size());
+	}
+	void test_added_file()
+	{
+		Directory_Scan scan({".mml", ".mds"});
+		scan.update(directory.string());
+		touch(directory / "sub" / "d.mml");
+		CPPUNIT_ASSERT(scan.update(directory.string()));
+		CPPUNIT_ASSERT_EQUAL((size_t)3, scan.get_files().size());
+
+		fs::remove(directory / "a.mml");
+		CPPUNIT_ASSERT(scan.update(directory.string()));
+		CPPUNIT_ASSERT_EQUAL((size_t)2, scan.get_files().size());
+	}
+	void test_other_directory()
+	{
+		Directory_Scan scan({".mml", ".mds"});
+		scan.update(directory.string());
+		CPPUNIT_ASSERT(scan.update((directory / "sub").string()));
+		CPPUNIT_ASSERT_EQUAL((size_t)1, scan.get_files().size());
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Directory_Scan_Test);
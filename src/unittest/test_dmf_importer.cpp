@@ -0,0 +1,108 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include "../dmf_importer.h"
+
+#define MINIZ_HEADER_FILE_ONLY
+#include "../miniz.c"
+
+namespace fs = std::filesystem;
+
+class Dmf_Importer_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Dmf_Importer_Test);
+	CPPUNIT_TEST(test_import);
+	CPPUNIT_TEST(test_large);
+	CPPUNIT_TEST(test_truncated);
+	CPPUNIT_TEST(test_not_compressed);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	std::string filename;
+
+	//! Make a Genesis module with one FM and one PSG instrument.
+	std::vector<uint8_t> make_module(size_t padding = 0)
+	{
+		std::vector<uint8_t> dmf(16, 0);
+		dmf.push_back(0x18);	// version
+		dmf.push_back(0x02);	// system
+		dmf.push_back(0);		// name
+		dmf.push_back(0);		// author
+		dmf.insert(dmf.end(), 10, 0);
+		dmf.insert(dmf.end(), {64, 0, 0, 0});	// pattern rows
+		dmf.push_back(1);		// matrix rows
+		dmf.insert(dmf.end(), 10, 0);
+		dmf.push_back(2);		// instruments
+
+		dmf.insert(dmf.end(), {2, 'f', 'm', 1});
+		std::vector<uint8_t> fm(52, 0);
+		fm[0] = 4;			// ALG
+		fm[1] = 5;			// FB
+		fm[4 + 1] = 31;		// AR of the first operator
+		fm[4 + 9] = 3;		// DT 0
+		fm[28 + 9] = 3;
+		fm[16 + 9] = 3;
+		fm[40 + 9] = 3;
+		dmf.insert(dmf.end(), fm.begin(), fm.end());
+
+		dmf.insert(dmf.end(), {3, 'p', 's', 'g', 0});
+		dmf.insert(dmf.end(), {2, 15, 0, 0, 0, 10, 0, 0, 0, 1});	// volume envelope, loop at 1
+		dmf.insert(dmf.end(), {0, 0, 0, 0});						// arp, arp mode, noise, wave
+
+		dmf.insert(dmf.end(), padding, 0);
+		return dmf;
+	}
+	void write(const std::vector<uint8_t>& dmf, bool packed = true)
+	{
+		std::vector<uint8_t> out = dmf;
+		if(packed)
+		{
+			mz_ulong size = mz_compressBound(dmf.size());
+			out.resize(size);
+			mz_compress(out.data(), &size, dmf.data(), dmf.size());
+			out.resize(size);
+		}
+		std::ofstream(filename, std::ios::binary).write((const char*)out.data(), out.size());
+	}
+public:
+	void setUp()
+	{
+		filename = (fs::temp_directory_path() / "mmlgui_test_dmf_importer.dmf").string();
+	}
+	void tearDown()
+	{
+		fs::remove(filename);
+	}
+	void test_import()
+	{
+		write(make_module());
+		Dmf_Importer importer(filename.c_str());
+		CPPUNIT_ASSERT_EQUAL(std::string(""), importer.get_error());
+		std::string mml = importer.get_mml();
+		CPPUNIT_ASSERT(mml.find("@0 fm 4 5 ; fm\n  31 ") == 0);
+		CPPUNIT_ASSERT(mml.find("@1 psg ; psg\n 15 | 10\n") != std::string::npos);
+	}
+	void test_large()
+	{
+		// Larger than the initial buffer, which must then grow
+		write(make_module(0x400000));
+		Dmf_Importer importer(filename.c_str());
+		CPPUNIT_ASSERT_EQUAL(std::string(""), importer.get_error());
+	}
+	void test_truncated()
+	{
+		auto dmf = make_module();
+		dmf.resize(dmf.size() - 20);
+		write(dmf);
+		Dmf_Importer importer(filename.c_str());
+		CPPUNIT_ASSERT_EQUAL(std::string("Unexpected end of file\n"), importer.get_error());
+	}
+	void test_not_compressed()
+	{
+		write(make_module(), false);
+		Dmf_Importer importer(filename.c_str());
+		CPPUNIT_ASSERT_EQUAL(std::string("File could not be decompressed\n"), importer.get_error());
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Dmf_Importer_Test);
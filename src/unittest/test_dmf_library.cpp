@@ -0,0 +1,106 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include "../dmf_library.h"
+
+#define MINIZ_HEADER_FILE_ONLY
+#include "../miniz.c"
+
+namespace fs = std::filesystem;
+
+class Dmf_Library_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Dmf_Library_Test);
+	CPPUNIT_TEST(test_dedup);
+	CPPUNIT_TEST(test_mml);
+	CPPUNIT_TEST(test_mapping);
+	CPPUNIT_TEST(test_error);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	fs::path directory;
+
+	//! Write a module with FM instruments, each given as (name, algorithm).
+	void write_module(const std::string& filename, const std::vector<std::pair<std::string, int>>& instruments)
+	{
+		std::vector<uint8_t> dmf(16, 0);
+		dmf.insert(dmf.end(), {0x18, 0x02, 0, 0});
+		dmf.insert(dmf.end(), 10, 0);
+		dmf.insert(dmf.end(), {64, 0, 0, 0, 0});
+		dmf.push_back(instruments.size());
+		for(auto&& i : instruments)
+		{
+			dmf.push_back(i.first.size());
+			dmf.insert(dmf.end(), i.first.begin(), i.first.end());
+			dmf.push_back(1);
+			std::vector<uint8_t> fm(52, 0);
+			fm[0] = i.second;
+			dmf.insert(dmf.end(), fm.begin(), fm.end());
+		}
+
+		mz_ulong size = mz_compressBound(dmf.size());
+		std::vector<uint8_t> out(size);
+		mz_compress(out.data(), &size, dmf.data(), dmf.size());
+		std::ofstream((directory / filename).string(), std::ios::binary).write((const char*)out.data(), size);
+	}
+	Dmf_Library build()
+	{
+		write_module("a.dmf", {{"bass", 1}, {"lead", 2}});
+		write_module("b.dmf", {{"other bass", 1}, {"pad", 3}, {"lead", 2}});
+		Dmf_Library library(2);
+		library.add_directory(directory.string());
+		return library;
+	}
+public:
+	void setUp()
+	{
+		directory = fs::temp_directory_path() / "mmlgui_test_dmf_library";
+		fs::remove_all(directory);
+		fs::create_directories(directory);
+	}
+	void tearDown()
+	{
+		fs::remove_all(directory);
+	}
+	void test_dedup()
+	{
+		Dmf_Library library = build();
+		CPPUNIT_ASSERT_EQUAL(2u, library.get_file_count());
+		CPPUNIT_ASSERT_EQUAL(5u, library.get_instrument_count());
+		auto& patches = library.get_patches();
+		CPPUNIT_ASSERT_EQUAL((size_t)3, patches.size());
+		CPPUNIT_ASSERT_EQUAL(std::string("bass"), patches[0].instrument.name);
+		CPPUNIT_ASSERT_EQUAL((size_t)2, patches[0].sources.size());
+		CPPUNIT_ASSERT_EQUAL(std::string("other bass"), patches[0].sources[1].name);
+		CPPUNIT_ASSERT_EQUAL(0, patches[0].sources[1].id);
+		CPPUNIT_ASSERT_EQUAL((size_t)2, patches[1].sources.size());
+		CPPUNIT_ASSERT_EQUAL(2, patches[1].sources[1].id);
+		CPPUNIT_ASSERT_EQUAL(std::string("pad"), patches[2].instrument.name);
+	}
+	void test_mml()
+	{
+		std::string mml = build().get_mml();
+		CPPUNIT_ASSERT(mml.find("@0 fm 1 0 ; bass\n") != std::string::npos);
+		CPPUNIT_ASSERT(mml.find("@1 fm 2 0 ; lead\n") != std::string::npos);
+		CPPUNIT_ASSERT(mml.find("@2 fm 3 0 ; pad\n") != std::string::npos);
+		CPPUNIT_ASSERT(mml.find("@3") == std::string::npos);
+		CPPUNIT_ASSERT(mml.find("b.dmf @0 other bass\n") != std::string::npos);
+	}
+	void test_mapping()
+	{
+		std::string map = build().get_mapping();
+		std::string b = (directory / "b.dmf").string();
+		CPPUNIT_ASSERT(map.find(b + "\t1\tpad\t2\n") != std::string::npos);
+		CPPUNIT_ASSERT(map.find(b + "\t2\tlead\t1\n") != std::string::npos);
+	}
+	void test_error()
+	{
+		std::ofstream((directory / "broken.dmf").string()) << "not a module";
+		Dmf_Library library = build();
+		CPPUNIT_ASSERT_EQUAL(3u, library.get_file_count());
+		CPPUNIT_ASSERT_EQUAL((size_t)1, library.get_errors().size());
+		CPPUNIT_ASSERT_EQUAL((size_t)3, library.get_patches().size());
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Dmf_Library_Test);
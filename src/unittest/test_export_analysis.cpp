@@ -0,0 +1,173 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdexcept>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include "../export_analysis.h"
+#include "../wave_loader.h"
+#include "song.h"
+#include "mml_input.h"
+#include "riff.h"
+#include "platform/mdsdrv.h"
+
+class Export_Analysis_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Export_Analysis_Test);
+	CPPUNIT_TEST(test_parse_riff);
+	CPPUNIT_TEST(test_truncated);
+	CPPUNIT_TEST(test_shared_pcm);
+	CPPUNIT_TEST(test_budget);
+	CPPUNIT_TEST(test_json);
+	CPPUNIT_TEST(test_mdsdrv_converter);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	static void append_chunk(std::vector<uint8_t>& out, const char* id, const std::vector<uint8_t>& data)
+	{
+		out.insert(out.end(), id, id + 4);
+		uint32_t size = data.size();
+		for(int i = 0; i < 4; i++)
+			out.push_back(size >> (i * 8));
+		out.insert(out.end(), data.begin(), data.end());
+		if(size & 1)
+			out.push_back(0);
+	}
+	static std::vector<uint8_t> list(const char* id, const char* type, const std::vector<uint8_t>& chunks)
+	{
+		std::vector<uint8_t> data(type, type + 4), out;
+		data.insert(data.end(), chunks.begin(), chunks.end());
+		append_chunk(out, id, data);
+		return out;
+	}
+	static std::vector<uint8_t> make_sample(size_t length, int seed = 0)
+	{
+		std::vector<uint8_t> data(length);
+		for(size_t i = 0; i < length; i++)
+			data[i] = i * 7 + seed;
+		return data;
+	}
+	//! Make a song with 5 bytes of sequence data and the given samples.
+	static std::vector<uint8_t> make_song(const std::vector<std::vector<uint8_t>>& samples)
+	{
+		std::vector<uint8_t> chunks, pcm;
+		append_chunk(chunks, "seq ", {1, 2, 3, 4, 5});
+		for(auto&& i : samples)
+			append_chunk(pcm, "data", i);
+		std::vector<uint8_t> pcm_list = list("LIST", "smpl", pcm);
+		chunks.insert(chunks.end(), pcm_list.begin(), pcm_list.end());
+		return list("RIFF", "MDS0", chunks);
+	}
+	//! Add a song made by make_song, with the samples as its linked PCM data.
+	static void add_song(Export_Analysis& analysis, const std::string& name, const std::vector<std::vector<uint8_t>>& samples)
+	{
+		std::vector<uint8_t> pcm_data;
+		for(auto&& i : samples)
+			pcm_data.insert(pcm_data.end(), i.begin(), i.end());
+		analysis.add_song(name, make_song(samples), 5, pcm_data.size(), pcm_data);
+	}
+public:
+	void test_parse_riff()
+	{
+		auto mds = make_song({{1, 2, 3}, {4, 5, 6, 7}});
+		auto chunks = Export_Analysis::parse_riff(mds.data(), mds.size());
+		CPPUNIT_ASSERT_EQUAL((size_t)3, chunks.size());
+		CPPUNIT_ASSERT_EQUAL(std::string("MDS0/seq "), chunks[0].path);
+		CPPUNIT_ASSERT_EQUAL(std::string("MDS0/smpl/data"), chunks[1].path);
+		CPPUNIT_ASSERT_EQUAL((size_t)3, chunks[1].size);
+		CPPUNIT_ASSERT_EQUAL((uint8_t)4, mds[chunks[2].offset]);
+
+		// Samples are found by content, not by chunk ID
+		Export_Analysis analysis;
+		add_song(analysis, "a", {make_sample(32), make_sample(20, 1)});
+		const auto& song = analysis.get_songs()[0];
+		CPPUNIT_ASSERT_EQUAL((size_t)5, song.sequence_bytes);
+		CPPUNIT_ASSERT_EQUAL((size_t)52, song.pcm_bytes);
+		CPPUNIT_ASSERT(!song.chunks[0].pcm);
+		CPPUNIT_ASSERT(song.chunks[1].pcm);
+		CPPUNIT_ASSERT(song.chunks[2].pcm);
+
+		// Chunks not in the PCM data, or too short to tell, are not samples
+		analysis.add_song("b", make_song({make_sample(32), {1, 2, 3}}), 5, 16, make_sample(16, 2));
+		CPPUNIT_ASSERT(!analysis.get_songs()[1].chunks[1].pcm);
+		CPPUNIT_ASSERT(!analysis.get_songs()[1].chunks[2].pcm);
+	}
+	void test_truncated()
+	{
+		auto mds = make_song({{1, 2, 3}});
+		mds.resize(mds.size() - 4);
+		Export_Analysis analysis;
+		CPPUNIT_ASSERT_THROW(analysis.add_song("a", mds, 5, 0, {}), std::runtime_error);
+		std::vector<uint8_t> wave = {'W', 'A', 'V', 'E', 0, 0, 0, 0, 0, 0, 0, 0};
+		CPPUNIT_ASSERT_THROW(analysis.add_song("b", wave, 0, 0, {}), std::runtime_error);
+	}
+	void test_shared_pcm()
+	{
+		Export_Analysis analysis;
+		add_song(analysis, "a", {make_sample(30), make_sample(40, 1)});
+		add_song(analysis, "b", {make_sample(40, 1)});
+		add_song(analysis, "c", {make_sample(40, 1), make_sample(40, 1)});
+		// The second copy within "c" is counted as its own sample
+		CPPUNIT_ASSERT_EQUAL((size_t)120, analysis.get_shared_pcm_bytes());
+	}
+	void test_budget()
+	{
+		Export_Analysis analysis;
+		analysis.set_output_size(100, 900);
+		analysis.set_budget(1500);
+		CPPUNIT_ASSERT_EQUAL(500LL, analysis.get_remaining_bytes());
+		analysis.set_budget(800);
+		CPPUNIT_ASSERT_EQUAL(-200LL, analysis.get_remaining_bytes());
+	}
+	void test_json()
+	{
+		Export_Analysis analysis;
+		add_song(analysis, "a\"b", {make_sample(20)});
+		add_song(analysis, "c", {make_sample(20)});
+		analysis.set_output_size(10, 2);
+		std::string json = analysis.to_json();
+		CPPUNIT_ASSERT(json.find("\"name\": \"a\\\"b\"") != std::string::npos);
+		CPPUNIT_ASSERT(json.find("\"shared_with\": [\"c\"]") != std::string::npos);
+		CPPUNIT_ASSERT(json.find("\"total_bytes\": 12") != std::string::npos);
+		CPPUNIT_ASSERT(json.find("\"remaining_bytes\": null") != std::string::npos);
+	}
+	void test_mdsdrv_converter()
+	{
+		// Convert a song with a PCM instrument, the same way as the export window
+		std::filesystem::path directory = std::filesystem::temp_directory_path() / "mmlgui_test_export_analysis";
+		std::filesystem::create_directories(directory);
+		std::vector<int16_t> samples(2000);
+		for(size_t i = 0; i < samples.size(); i++)
+			samples[i] = (i * 1337) % 20000 - 10000;
+		save_wave_file((directory / "sample.wav").string(), samples.data(), samples.size(), 17500, 1);
+
+		Song song;
+		song.add_tag("include_path", directory.string() + "/");
+		MML_Input input(&song);
+		input.read_line("@30 pcm \"sample.wav\"", 0);
+		input.read_line("A l8 cdef", 1);
+		input.read_line("F mode1 l16 @30 c", 2);
+		MDSDRV_Converter converter(song);
+		RIFF mds = converter.get_mds();
+		std::filesystem::remove_all(directory);
+
+		MDSDRV_Linker linker;
+		linker.add_song(mds, "song");
+		std::vector<uint8_t> pcm_data = linker.get_pcm_data();
+		size_t seq_size = linker.get_seq_data().size();
+
+		Export_Analysis analysis;
+		analysis.add_song("song", mds.to_bytes(), seq_size, pcm_data.size(), pcm_data);
+		const auto& result = analysis.get_songs()[0];
+		CPPUNIT_ASSERT(result.chunks.size() > 1);
+		CPPUNIT_ASSERT_EQUAL(seq_size, result.sequence_bytes);
+		CPPUNIT_ASSERT_EQUAL(pcm_data.size(), result.pcm_bytes);
+		CPPUNIT_ASSERT(result.pcm_bytes > 0);
+
+		size_t pcm_chunks = 0;
+		for(auto&& chunk : result.chunks)
+			pcm_chunks += chunk.pcm;
+		CPPUNIT_ASSERT(pcm_chunks > 0);
+		CPPUNIT_ASSERT(pcm_chunks < result.chunks.size());
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Export_Analysis_Test);
@@ -0,0 +1,78 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <filesystem>
+#include <fstream>
+#include "../export_cache.h"
+
+namespace fs = std::filesystem;
+
+class Export_Cache_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Export_Cache_Test);
+	CPPUNIT_TEST(test_dependencies);
+	CPPUNIT_TEST(test_key);
+	CPPUNIT_TEST(test_store);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	fs::path dir;
+
+	void write(const std::string& name, const std::string& text)
+	{
+		std::ofstream out(dir / name, std::ios::binary);
+		out << text;
+	}
+public:
+	void setUp()
+	{
+		dir = fs::temp_directory_path() / "mmlgui_test_export_cache";
+		fs::remove_all(dir);
+		fs::create_directories(dir);
+		write("song.mml", "#title \"Not a file\"\n*30 \"kick.wav\"\n@1 \"sub.mml\"\n\"missing.wav\"\n");
+		write("sub.mml", "*31 \"snare.wav\"\n");
+		write("kick.wav", "kick");
+		write("snare.wav", "snare");
+	}
+	void tearDown()
+	{
+		fs::remove_all(dir);
+	}
+	void test_dependencies()
+	{
+		auto deps = Export_Cache::find_dependencies((dir / "song.mml").string());
+		CPPUNIT_ASSERT_EQUAL((size_t)3, deps.size());
+		CPPUNIT_ASSERT_EQUAL((dir / "kick.wav").string(), deps[0]);
+		CPPUNIT_ASSERT_EQUAL((dir / "snare.wav").string(), deps[1]);
+		CPPUNIT_ASSERT_EQUAL((dir / "sub.mml").string(), deps[2]);
+	}
+	void test_key()
+	{
+		Export_Cache cache((dir / "cache").string());
+		std::string song = (dir / "song.mml").string();
+		std::string key = cache.get_key(song);
+		CPPUNIT_ASSERT_EQUAL(key, cache.get_key(song));
+
+		// A change in a nested dependency changes the key
+		write("snare.wav", "snare2");
+		CPPUNIT_ASSERT(key != cache.get_key(song));
+	}
+	void test_store()
+	{
+		std::vector<uint8_t> data = {1, 2, 3}, loaded;
+		{
+			Export_Cache cache((dir / "cache").string());
+			CPPUNIT_ASSERT(!cache.load("a", loaded));
+			cache.store("a", data);
+			cache.store("b", data);
+		}
+		{
+			Export_Cache cache((dir / "cache").string());
+			CPPUNIT_ASSERT(cache.load("a", loaded));
+			CPPUNIT_ASSERT(data == loaded);
+			CPPUNIT_ASSERT_EQUAL(1u, cache.get_hit_count());
+			cache.prune();
+		}
+		CPPUNIT_ASSERT(fs::exists(dir / "cache" / "a.mds"));
+		CPPUNIT_ASSERT(!fs::exists(dir / "cache" / "b.mds"));
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Export_Cache_Test);
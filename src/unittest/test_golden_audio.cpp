@@ -0,0 +1,155 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "../emu_player.h"
+#include "../song_manager.h"
+#include "../wave_loader.h"
+#include "../audio_compare.h"
+#include "song.h"
+#include "input.h"
+#include "mml_input.h"
+#include "stringf.h"
+
+namespace fs = std::filesystem;
+
+//! Renders every song in the golden directory and compares it to a reference WAV.
+/*!
+ *  A missing reference is a failure. References are only written when
+ *  MMLGUI_UPDATE_GOLDEN=1 is set; do this on a known-good build, to add a
+ *  new song or after an intended change in the output.
+ */
+class Golden_Audio_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Golden_Audio_Test);
+	CPPUNIT_TEST(test_golden_audio);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	const static uint32_t sample_rate = 44100;
+	const static unsigned int max_seconds = 20;
+	const static int block_size = 64;		// frames rendered between driver tick readings
+	const static int tolerance = 2;
+
+	struct Rendering
+	{
+		std::vector<int16_t> samples;		// interleaved stereo
+		std::vector<int64_t> block_ticks;	// driver tick at the start of each block
+	};
+
+	static int16_t clip16(int32_t input)
+	{
+		return std::min(std::max(input, -32768), 32767);
+	}
+
+	//! Render a song offline.
+	/*!
+	 *  Lines are read the same way as Song_Manager::compile_job. The output
+	 *  is converted to 16-bit like Audio_Manager at unity gain; no stream,
+	 *  bus or master volume is applied.
+	 */
+	static Rendering render(const fs::path& filename)
+	{
+		auto song = std::make_shared<Song>();
+		song->add_tag("include_path", filename.parent_path().string() + "/");
+		MML_Input input(song.get());
+		std::ifstream in(filename);
+		std::string line;
+		for(int line_number = 0; std::getline(in, line); line_number++)
+			input.read_line(Song_Manager::tabs_to_spaces(line), line_number);
+
+		Rendering rendering;
+		Emu_Player player(song);
+		player.setup_stream(sample_rate);
+		std::vector<WAVE_32BS> buffer(block_size);
+		int64_t tick = 0;
+		for(size_t frame = 0; frame < sample_rate * max_seconds && !player.get_finished(); frame += block_size)
+		{
+			memset(buffer.data(), 0, buffer.size() * sizeof(WAVE_32BS));
+			rendering.block_ticks.push_back(tick);
+			player.get_sample(buffer.data(), block_size, 2);
+			for(auto&& i : buffer)
+			{
+				rendering.samples.push_back(clip16(i.L >> 8));
+				rendering.samples.push_back(clip16(i.R >> 8));
+			}
+			tick = player.get_position();
+		}
+		return rendering;
+	}
+
+	static std::string describe(const std::string& name, const Rendering& rendering, const Audio_Difference& diff)
+	{
+		size_t block = std::min(diff.first_frame / block_size, rendering.block_ticks.size() - 1);
+		std::string str = stringf("%s: first difference at frame %zu (%.4f s, tick %lld)",
+			name.c_str(), diff.first_frame, (double)diff.first_frame / sample_rate,
+			(long long)rendering.block_ticks[block]);
+		if(diff.channel < 0)
+			str += ", length differs";
+		else
+			str += stringf(", %s channel: expected %d, got %d", diff.channel ? "right" : "left", diff.expected, diff.actual);
+		str += stringf("; %zu samples differ, max difference %d\n", diff.differing_samples, diff.max_difference);
+		return str;
+	}
+public:
+	void test_golden_audio()
+	{
+		fs::path directory = "src/unittest/golden";
+		CPPUNIT_ASSERT_MESSAGE("Golden audio directory not found, run from the source directory", fs::is_directory(directory));
+		const char* update_env = getenv("MMLGUI_UPDATE_GOLDEN");
+		bool update = update_env && std::strcmp(update_env, "0");
+
+		std::vector<fs::path> songs;
+		for(auto&& entry : fs::directory_iterator(directory))
+			if(entry.path().extension() == ".mml")
+				songs.push_back(entry.path());
+		std::sort(songs.begin(), songs.end());
+		CPPUNIT_ASSERT(songs.size() > 0);
+
+		std::string failures;
+		for(auto&& song : songs)
+		{
+			std::string name = song.stem().string();
+			fs::path reference = fs::path(song).replace_extension(".wav");
+			Rendering rendering;
+			try
+			{
+				rendering = render(song);
+			}
+			catch(std::exception& e)
+			{
+				failures += name + ": " + e.what() + "\n";
+				continue;
+			}
+			size_t frames = rendering.samples.size() / 2;
+
+			if(update)
+			{
+				save_wave_file(reference.string(), rendering.samples.data(), frames, sample_rate, 2);
+				printf("%s: recorded reference (%zu frames)\n", name.c_str(), frames);
+				continue;
+			}
+			if(!fs::exists(reference))
+			{
+				failures += name + ": no reference " + reference.string()
+					+ ", record it with MMLGUI_UPDATE_GOLDEN=1 on a known-good build\n";
+				continue;
+			}
+
+			Wave_Data expected = load_wave_file(reference.string());
+			if(expected.channels != 2 || expected.sample_rate != sample_rate)
+			{
+				failures += name + ": reference must be 16-bit stereo at 44100 Hz\n";
+				continue;
+			}
+			Audio_Difference diff = compare_audio(expected.samples.data(), expected.get_frames(),
+				rendering.samples.data(), frames, 2, tolerance);
+			if(!diff.matches)
+				failures += describe(name, rendering, diff);
+		}
+		CPPUNIT_ASSERT_MESSAGE("\n" + failures, failures.empty());
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Golden_Audio_Test);
@@ -0,0 +1,55 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include "../mapped_file.h"
+
+namespace fs = std::filesystem;
+
+class Mapped_File_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Mapped_File_Test);
+	CPPUNIT_TEST(test_read);
+	CPPUNIT_TEST(test_empty);
+	CPPUNIT_TEST(test_missing);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	std::string filename;
+public:
+	void setUp()
+	{
+		filename = (fs::temp_directory_path() / "mmlgui_test_mapped_file.bin").string();
+		fs::remove(filename);
+	}
+	void tearDown()
+	{
+		fs::remove(filename);
+	}
+	void test_read()
+	{
+		{
+			std::ofstream out(filename, std::ios::binary);
+			for(int i = 0; i < 100000; i++)
+				out.put((char)(i * 7));
+		}
+		Mapped_File file(filename);
+		CPPUNIT_ASSERT_EQUAL((size_t)100000, file.size());
+		int mismatches = 0;
+		for(int i = 0; i < 100000; i++)
+			if(file.data()[i] != (uint8_t)(i * 7))
+				mismatches++;
+		CPPUNIT_ASSERT_EQUAL(0, mismatches);
+	}
+	void test_empty()
+	{
+		std::ofstream(filename, std::ios::binary).close();
+		Mapped_File file(filename);
+		CPPUNIT_ASSERT_EQUAL((size_t)0, file.size());
+	}
+	void test_missing()
+	{
+		CPPUNIT_ASSERT_THROW(Mapped_File file(filename), std::runtime_error);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Mapped_File_Test);
@@ -0,0 +1,66 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <vector>
+#include "../mix_matrix.h"
+
+class Mix_Matrix_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Mix_Matrix_Test);
+	CPPUNIT_TEST(test_downmix);
+	CPPUNIT_TEST(test_select);
+	CPPUNIT_TEST(test_in_place);
+	CPPUNIT_TEST(test_surround);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void test_downmix()
+	{
+		const int16_t stereo[4] = {100, 300, -100, -301};
+		int16_t mono[2];
+		Mix_Matrix::downmix(2, 1).process(stereo, mono, 2);
+		CPPUNIT_ASSERT_EQUAL((int16_t)200, mono[0]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)-200, mono[1]);
+
+		int16_t expanded[4];
+		Mix_Matrix::downmix(1, 2).process(mono, expanded, 2);
+		CPPUNIT_ASSERT_EQUAL((int16_t)200, expanded[0]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)200, expanded[1]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)-200, expanded[2]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)-200, expanded[3]);
+	}
+	void test_select()
+	{
+		const int16_t stereo[4] = {100, 300, -100, -301};
+		int16_t mono[2];
+		Mix_Matrix::select(2, 1).process(stereo, mono, 2);
+		CPPUNIT_ASSERT_EQUAL((int16_t)300, mono[0]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)-301, mono[1]);
+	}
+	void test_in_place()
+	{
+		// Longer than one block
+		std::vector<int16_t> data(1000 * 2);
+		for(int i = 0; i < 1000; i++)
+		{
+			data[i * 2] = i;
+			data[i * 2 + 1] = i + 2;
+		}
+		Mix_Matrix::downmix(2, 1).process(data.data(), data.data(), 1000);
+		for(int i = 0; i < 1000; i++)
+			CPPUNIT_ASSERT_EQUAL((int16_t)(i + 1), data[i]);
+	}
+	void test_surround()
+	{
+		// 5.1 at full scale must not clip, and LFE is not included
+		const int16_t frame[6] = {32767, 32767, 32767, 32767, 32767, 32767};
+		int16_t stereo[2];
+		Mix_Matrix::downmix(6, 2).process(frame, stereo, 1);
+		CPPUNIT_ASSERT_EQUAL((int16_t)32767, stereo[0]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)32767, stereo[1]);
+
+		const int16_t lfe[6] = {0, 0, 0, 32767, 0, 0};
+		Mix_Matrix::downmix(6, 2).process(lfe, stereo, 1);
+		CPPUNIT_ASSERT_EQUAL((int16_t)0, stereo[0]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)0, stereo[1]);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Mix_Matrix_Test);
@@ -0,0 +1,99 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "../output_file.h"
+
+namespace fs = std::filesystem;
+
+class Output_File_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Output_File_Test);
+	CPPUNIT_TEST(test_new_file);
+	CPPUNIT_TEST(test_unchanged);
+	CPPUNIT_TEST(test_changed);
+	CPPUNIT_TEST(test_length);
+	CPPUNIT_TEST(test_no_commit);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	std::string filename;
+
+	bool write(const std::vector<uint8_t>& data, size_t chunk = 1000)
+	{
+		Output_File file(filename);
+		for(size_t i = 0; i < data.size(); i += chunk)
+			file.write(data.data() + i, std::min(chunk, data.size() - i));
+		return file.commit();
+	}
+	std::vector<uint8_t> read()
+	{
+		std::ifstream in(filename, std::ios::binary);
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+	std::vector<uint8_t> make_data(size_t length)
+	{
+		std::vector<uint8_t> data(length);
+		for(size_t i = 0; i < length; i++)
+			data[i] = i * 7;
+		return data;
+	}
+public:
+	void setUp()
+	{
+		filename = (fs::temp_directory_path() / "mmlgui_test_output_file.bin").string();
+		fs::remove(filename);
+	}
+	void tearDown()
+	{
+		fs::remove(filename);
+	}
+	void test_new_file()
+	{
+		auto data = make_data(200000);
+		CPPUNIT_ASSERT(write(data));
+		CPPUNIT_ASSERT(data == read());
+		CPPUNIT_ASSERT(!fs::exists(filename + ".tmp"));
+	}
+	void test_unchanged()
+	{
+		auto data = make_data(200000);
+		write(data);
+		auto time = fs::last_write_time(filename);
+		CPPUNIT_ASSERT(!write(data, 333));
+		CPPUNIT_ASSERT(time == fs::last_write_time(filename));
+		CPPUNIT_ASSERT(data == read());
+	}
+	void test_changed()
+	{
+		auto data = make_data(200000);
+		write(data);
+		data[150000] ^= 1;
+		CPPUNIT_ASSERT(write(data));
+		CPPUNIT_ASSERT(data == read());
+	}
+	void test_length()
+	{
+		auto data = make_data(100000);
+		write(data);
+		data.resize(90000);
+		CPPUNIT_ASSERT(write(data));
+		CPPUNIT_ASSERT(data == read());
+		data = make_data(110000);
+		CPPUNIT_ASSERT(write(data));
+		CPPUNIT_ASSERT(data == read());
+	}
+	void test_no_commit()
+	{
+		auto data = make_data(1000);
+		write(data);
+		{
+			Output_File file(filename);
+			file.write("x", 1);
+		}
+		CPPUNIT_ASSERT(data == read());
+		CPPUNIT_ASSERT(!fs::exists(filename + ".tmp"));
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Output_File_Test);
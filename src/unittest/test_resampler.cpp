@@ -0,0 +1,46 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <vector>
+#include <cmath>
+#include "../resampler.h"
+
+class Resampler_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Resampler_Test);
+	CPPUNIT_TEST(test_length);
+	CPPUNIT_TEST(test_dc);
+	CPPUNIT_TEST(test_alias);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void test_length()
+	{
+		std::vector<int16_t> input(44100, 0);
+		for(int i = 0; i < Resampler::QUALITY_COUNT; i++)
+		{
+			Resampler resampler(44100, 17500, (Resampler::Quality)i);
+			CPPUNIT_ASSERT_EQUAL((size_t)17500, resampler.process(input.data(), input.size()).size());
+		}
+	}
+	void test_dc()
+	{
+		std::vector<int16_t> input(4000, 1000);
+		Resampler resampler(44100, 17500);
+		auto output = resampler.process(input.data(), input.size());
+		// skip the filter's edges
+		for(size_t i = 100; i < output.size() - 100; i++)
+			CPPUNIT_ASSERT_EQUAL((int16_t)1000, output[i]);
+	}
+	void test_alias()
+	{
+		// 15 kHz is above the Nyquist frequency of the output
+		std::vector<int16_t> input(44100);
+		for(size_t i = 0; i < input.size(); i++)
+			input[i] = 16000 * std::sin(2 * M_PI * 15000 * i / 44100);
+		Resampler resampler(44100, 8750);
+		auto output = resampler.process(input.data(), input.size());
+		for(size_t i = 100; i < output.size() - 100; i++)
+			CPPUNIT_ASSERT(std::abs(output[i]) < 16);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Resampler_Test);
+
@@ -0,0 +1,45 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <vector>
+#include "../ring_buffer.h"
+
+class Ring_Buffer_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Ring_Buffer_Test);
+	CPPUNIT_TEST(test_size);
+	CPPUNIT_TEST(test_wrap);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void test_size()
+	{
+		Ring_Buffer<int> ring(100);
+		CPPUNIT_ASSERT_EQUAL((size_t)128, ring.capacity());
+		CPPUNIT_ASSERT_EQUAL((size_t)0, ring.size());
+		CPPUNIT_ASSERT_EQUAL((size_t)128, ring.space());
+
+		std::vector<int> data(200, 1);
+		CPPUNIT_ASSERT_EQUAL((size_t)128, ring.write(data.data(), data.size()));
+		CPPUNIT_ASSERT_EQUAL((size_t)0, ring.space());
+		CPPUNIT_ASSERT_EQUAL((size_t)128, ring.read(data.data(), data.size()));
+		CPPUNIT_ASSERT_EQUAL((size_t)0, ring.read(data.data(), data.size()));
+	}
+	void test_wrap()
+	{
+		Ring_Buffer<int> ring(8);
+		int in[6] = {1, 2, 3, 4, 5, 6};
+		int out[6] = {};
+		ring.write(in, 6);
+		CPPUNIT_ASSERT_EQUAL((size_t)4, ring.read(out, 4));
+		// this write wraps around the end of the buffer
+		CPPUNIT_ASSERT_EQUAL((size_t)6, ring.write(in, 6));
+		CPPUNIT_ASSERT_EQUAL((size_t)8, ring.size());
+		CPPUNIT_ASSERT_EQUAL((size_t)2, ring.read(out, 2));
+		CPPUNIT_ASSERT_EQUAL(5, out[0]);
+		CPPUNIT_ASSERT_EQUAL(6, out[1]);
+		CPPUNIT_ASSERT_EQUAL((size_t)6, ring.read(out, 6));
+		for(int i = 0; i < 6; i++)
+			CPPUNIT_ASSERT_EQUAL(in[i], out[i]);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Ring_Buffer_Test);
+
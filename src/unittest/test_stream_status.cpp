@@ -0,0 +1,56 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <thread>
+#include <atomic>
+#include "../stream_status.h"
+
+class Stream_Status_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Stream_Status_Test);
+	CPPUNIT_TEST(test_publish);
+	CPPUNIT_TEST(test_concurrent_read);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void test_publish()
+	{
+		Stream_Status status;
+		CPPUNIT_ASSERT_EQUAL(Stream_Status::IDLE, status.read().state);
+		CPPUNIT_ASSERT_EQUAL((uint32_t)0, status.get_update_count());
+
+		status.publish({1234, 100, 200, Stream_Status::PLAYING});
+		Stream_Status::Snapshot s = status.read();
+		CPPUNIT_ASSERT_EQUAL((int64_t)1234, s.position);
+		CPPUNIT_ASSERT_EQUAL((uint16_t)100, s.peak_left);
+		CPPUNIT_ASSERT_EQUAL((uint16_t)200, s.peak_right);
+		CPPUNIT_ASSERT_EQUAL(Stream_Status::PLAYING, s.state);
+		CPPUNIT_ASSERT_EQUAL((uint32_t)1, status.get_update_count());
+	}
+	void test_concurrent_read()
+	{
+		// Every published snapshot has all fields derived from the same
+		// counter, so a torn read would show up as a mismatch.
+		Stream_Status status;
+		std::atomic<bool> done(false);
+		std::thread writer([&]()
+		{
+			for(int i = 1; i <= 200000; i++)
+				status.publish({i, (uint16_t)(i & 0x7fff), (uint16_t)(~i & 0x7fff), Stream_Status::PLAYING});
+			done = true;
+		});
+		int mismatches = 0;
+		int64_t last = 0;
+		while(!done)
+		{
+			Stream_Status::Snapshot s = status.read();
+			if(s.position && (s.peak_left != (s.position & 0x7fff) || s.peak_right != (~s.position & 0x7fff)))
+				mismatches++;
+			if(s.position < last)
+				mismatches++;
+			last = s.position;
+		}
+		writer.join();
+		CPPUNIT_ASSERT_EQUAL(0, mismatches);
+		CPPUNIT_ASSERT_EQUAL((int64_t)200000, status.read().position);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Stream_Status_Test);
@@ -0,0 +1,67 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <vector>
+#include <filesystem>
+#include "../wave_loader.h"
+
+class Wave_Loader_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Wave_Loader_Test);
+	CPPUNIT_TEST(test_convert);
+	CPPUNIT_TEST(test_downmix);
+	CPPUNIT_TEST(test_save_8bit);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void test_convert()
+	{
+		int16_t out[2];
+
+		const uint8_t u8[2] = {0x00, 0xff};
+		convert_pcm(u8, out, 2, 8);
+		CPPUNIT_ASSERT_EQUAL((int16_t)-32768, out[0]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)0x7f00, out[1]);
+
+		const uint8_t s16[4] = {0x34, 0x12, 0x00, 0x80};
+		convert_pcm(s16, out, 2, 16);
+		CPPUNIT_ASSERT_EQUAL((int16_t)0x1234, out[0]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)-32768, out[1]);
+
+		const uint8_t s24[6] = {0x56, 0x34, 0x12, 0xff, 0xff, 0xff};
+		convert_pcm(s24, out, 2, 24);
+		CPPUNIT_ASSERT_EQUAL((int16_t)0x1234, out[0]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)-1, out[1]);
+
+		const uint8_t s32[8] = {0x78, 0x56, 0x34, 0x12, 0x00, 0x00, 0x00, 0x80};
+		convert_pcm(s32, out, 2, 32);
+		CPPUNIT_ASSERT_EQUAL((int16_t)0x1234, out[0]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)-32768, out[1]);
+	}
+	void test_downmix()
+	{
+		const int16_t stereo[4] = {100, 300, -100, -301};
+		int16_t out[2];
+		downmix_to_mono(stereo, out, 2, 2);
+		CPPUNIT_ASSERT_EQUAL((int16_t)200, out[0]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)-200, out[1]);
+
+		const int16_t quad[4] = {32767, 32767, 32767, 32767};
+		downmix_to_mono(quad, out, 1, 4);
+		CPPUNIT_ASSERT_EQUAL((int16_t)32767, out[0]);
+	}
+	void test_save_8bit()
+	{
+		std::string filename = (std::filesystem::temp_directory_path() / "mmlgui_test_8bit.wav").string();
+		const int16_t samples[3] = {-32768, 0x1280, 32767};
+		save_wave_file(filename, samples, 3, 17500, 1, 8);
+		Wave_Data wave = load_wave_file(filename);
+		std::filesystem::remove(filename);
+
+		CPPUNIT_ASSERT_EQUAL((uint32_t)17500, wave.sample_rate);
+		CPPUNIT_ASSERT_EQUAL((size_t)3, wave.samples.size());
+		CPPUNIT_ASSERT_EQUAL((int16_t)-32768, wave.samples[0]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)0x1300, wave.samples[1]);
+		CPPUNIT_ASSERT_EQUAL((int16_t)0x7f00, wave.samples[2]);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Wave_Loader_Test);
+
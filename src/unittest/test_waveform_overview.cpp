@@ -0,0 +1,73 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <vector>
+#include <algorithm>
+#include "../waveform_overview.h"
+
+class Waveform_Overview_Test : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(Waveform_Overview_Test);
+	CPPUNIT_TEST(test_peak);
+	CPPUNIT_TEST(test_short);
+	CPPUNIT_TEST(test_stereo);
+	CPPUNIT_TEST(test_shared);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void test_peak()
+	{
+		std::vector<int16_t> data(100000, 0);
+		data[12345] = 1000;
+		data[54321] = -2000;
+		Waveform_Overview overview;
+		overview.build(std::make_shared<std::vector<int16_t>>(data));
+
+		Waveform_Overview::Peak peak = overview.get_peak(0, data.size());
+		CPPUNIT_ASSERT_EQUAL((int16_t)-2000, peak.min);
+		CPPUNIT_ASSERT_EQUAL((int16_t)1000, peak.max);
+
+		peak = overview.get_peak(10000, 20000);
+		CPPUNIT_ASSERT_EQUAL((int16_t)0, peak.min);
+		CPPUNIT_ASSERT_EQUAL((int16_t)1000, peak.max);
+	}
+	void test_short()
+	{
+		std::vector<int16_t> data = {1, -5, 3, 7};
+		Waveform_Overview overview;
+		overview.build(std::make_shared<std::vector<int16_t>>(data));
+
+		Waveform_Overview::Peak peak = overview.get_peak(1, 3);
+		CPPUNIT_ASSERT_EQUAL((int16_t)-5, peak.min);
+		CPPUNIT_ASSERT_EQUAL((int16_t)3, peak.max);
+	}
+	void test_stereo()
+	{
+		std::vector<int16_t> data(2 * 50000, 0);
+		data[2 * 20000] = 500;			// left
+		data[2 * 30000 + 1] = -600;		// right
+		Waveform_Overview overview;
+		overview.build(std::make_shared<std::vector<int16_t>>(data), 2);
+		CPPUNIT_ASSERT_EQUAL((size_t)50000, overview.get_length());
+
+		Waveform_Overview::Peak peak = overview.get_peak(0, 50000);
+		CPPUNIT_ASSERT_EQUAL((int16_t)-600, peak.min);
+		CPPUNIT_ASSERT_EQUAL((int16_t)500, peak.max);
+
+		peak = overview.get_peak(29999, 30001);
+		CPPUNIT_ASSERT_EQUAL((int16_t)-600, peak.min);
+		CPPUNIT_ASSERT_EQUAL((int16_t)0, peak.max);
+	}
+	void test_shared()
+	{
+		// The overview must keep its data when the owner replaces it
+		auto data = std::make_shared<const std::vector<int16_t>>(std::vector<int16_t>{4, -8, 2});
+		Waveform_Overview overview;
+		overview.build(data);
+		data = std::make_shared<const std::vector<int16_t>>();
+
+		Waveform_Overview::Peak peak = overview.get_peak(0, 3);
+		CPPUNIT_ASSERT_EQUAL((int16_t)-8, peak.min);
+		CPPUNIT_ASSERT_EQUAL((int16_t)4, peak.max);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Waveform_Overview_Test);
+
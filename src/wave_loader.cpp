@@ -0,0 +1,312 @@
+#include "wave_loader.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+//! Size of the blocks read from the file.
+static const size_t read_block_size = 256 * 1024;
+
+static inline uint16_t read_le16(const uint8_t* data)
+{
+	return data[0] | (data[1] << 8);
+}
+
+static inline uint32_t read_le32(const uint8_t* data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+//! Skip bytes in a file that may not be seekable.
+static void skip_bytes(FILE* file, uint32_t length, bool seekable)
+{
+	if(seekable)
+	{
+		fseek(file, length, SEEK_CUR);
+		return;
+	}
+	uint8_t buffer[4096];
+	while(length)
+	{
+		size_t read = fread(buffer, 1, std::min<size_t>(length, sizeof(buffer)), file);
+		if(!read)
+			break;
+		length -= read;
+	}
+}
+
+//! Read a WAV file from an open stream.
+static Wave_Data read_wave(FILE* file, bool seekable)
+{
+	uint8_t header[12];
+	if(fread(header, 1, 12, file) != 12 || memcmp(header, "RIFF", 4) != 0)
+		throw std::runtime_error("Not a valid WAV file (RIFF header missing)");
+	if(memcmp(header + 8, "WAVE", 4) != 0)
+		throw std::runtime_error("Not a valid WAV file (WAVE header missing)");
+
+	Wave_Data wave = {};
+	uint16_t audio_format = 0;
+	uint16_t bits_per_sample = 0;
+	bool found_fmt = false;
+
+	uint8_t chunk_header[8];
+	while(fread(chunk_header, 1, 8, file) == 8)
+	{
+		uint32_t chunk_size = read_le32(chunk_header + 4);
+
+		if(memcmp(chunk_header, "fmt ", 4) == 0)
+		{
+			uint8_t fmt[40] = {};
+			size_t fmt_size = std::min<size_t>(chunk_size, sizeof(fmt));
+			if(chunk_size < 16 || fread(fmt, 1, fmt_size, file) != fmt_size)
+				throw std::runtime_error("Invalid WAV format chunk");
+
+			audio_format = read_le16(fmt + 0);
+			wave.channels = read_le16(fmt + 2);
+			wave.sample_rate = read_le32(fmt + 4);
+			bits_per_sample = read_le16(fmt + 14);
+
+			// WAVE_FORMAT_EXTENSIBLE: the format is in the sub format GUID
+			if(audio_format == 0xfffe && fmt_size >= 26)
+				audio_format = read_le16(fmt + 24);
+
+			skip_bytes(file, chunk_size - fmt_size + (chunk_size & 1), seekable);
+			found_fmt = true;
+		}
+		else if(memcmp(chunk_header, "data", 4) == 0)
+		{
+			if(!found_fmt || wave.channels == 0)
+				throw std::runtime_error("Invalid WAV format (missing format info)");
+
+			bool is_float = (audio_format == 3);
+			if(audio_format != 1 && !(is_float && bits_per_sample == 32))
+				throw std::runtime_error("Unsupported audio format (only PCM supported)");
+			if(bits_per_sample != 8 && bits_per_sample != 16 && bits_per_sample != 24 && bits_per_sample != 32)
+				throw std::runtime_error("Unsupported bit depth: " + std::to_string(bits_per_sample));
+
+			size_t bytes_per_sample = bits_per_sample / 8;
+			size_t frame_size = bytes_per_sample * wave.channels;
+			size_t frames = chunk_size / frame_size;
+
+			// Don't trust the chunk size when allocating the buffer. Streams
+			// written to a pipe don't know their size and use 0 or 0xffffffff.
+			if(!seekable && !chunk_size)
+			{
+				frames = SIZE_MAX;
+			}
+			else if(seekable)
+			{
+				long data_start = ftell(file);
+				fseek(file, 0, SEEK_END);
+				long data_end = ftell(file);
+				fseek(file, data_start, SEEK_SET);
+				if(data_start >= 0 && data_end >= data_start)
+					frames = std::min<size_t>(frames, (data_end - data_start) / frame_size);
+				wave.samples.reserve(frames * wave.channels);
+			}
+
+			// Read whole frames at a time
+			size_t block_frames = std::max<size_t>(read_block_size / frame_size, 1);
+			std::vector<uint8_t> buffer(block_frames * frame_size);
+			size_t position = 0;
+			while(position < frames)
+			{
+				size_t length = std::min(block_frames, frames - position);
+				size_t read = fread(buffer.data(), frame_size, length, file);
+				wave.samples.resize((position + read) * wave.channels);
+				convert_pcm(buffer.data(), &wave.samples[position * wave.channels],
+					read * wave.channels, bits_per_sample, is_float);
+				position += read;
+				if(read < length)
+					break;
+			}
+
+			if(!position)
+				throw std::runtime_error("No audio data found in WAV file");
+			return wave;
+		}
+		else
+		{
+			// Skip unknown chunks, which are aligned to word boundary
+			skip_bytes(file, chunk_size + (chunk_size & 1), seekable);
+		}
+	}
+	throw std::runtime_error("No audio data found in WAV file");
+}
+
+//! Load a WAV file.
+/*!
+ *  The sample data is read in large blocks and converted straight into
+ *  the interleaved output buffer, which is allocated once from the size of
+ *  the data chunk.
+ *
+ *  Supports 8, 16, 24 and 32-bit integer PCM as well as 32-bit float.
+ *
+ *  \exception std::runtime_error if the file can't be read or the format
+ *             is not supported.
+ */
+Wave_Data load_wave_file(const std::string& filename)
+{
+	std::unique_ptr<FILE, decltype(&fclose)> file(fopen(filename.c_str(), "rb"), &fclose);
+	if(!file)
+		throw std::runtime_error("Failed to open audio file");
+	return read_wave(file.get(), true);
+}
+
+//! Load a WAV file from a stream that can't seek, such as a pipe.
+/*!
+ *  \exception std::runtime_error if the data can't be read or the format
+ *             is not supported.
+ */
+Wave_Data load_wave_stream(FILE* file)
+{
+	return read_wave(file, false);
+}
+
+static inline void write_le16(uint8_t* data, uint16_t value)
+{
+	data[0] = value;
+	data[1] = value >> 8;
+}
+
+static inline void write_le32(uint8_t* data, uint32_t value)
+{
+	write_le16(data, value);
+	write_le16(data + 2, value >> 16);
+}
+
+//! Save PCM data to a WAV file.
+/*!
+ *  With 8 bits per sample, the samples are rounded and stored as unsigned
+ *  bytes, as in any 8-bit WAV file. Other values write 16-bit samples.
+ *
+ *  \exception std::runtime_error if the file can't be written.
+ */
+void save_wave_file(const std::string& filename, const int16_t* samples, size_t frames, uint32_t sample_rate, uint16_t channels, int bits_per_sample)
+{
+	std::unique_ptr<FILE, decltype(&fclose)> file(fopen(filename.c_str(), "wb"), &fclose);
+	if(!file)
+		throw std::runtime_error("Failed to open " + filename + " for writing");
+
+	int bytes_per_sample = (bits_per_sample == 8) ? 1 : 2;
+	uint32_t data_size = frames * channels * bytes_per_sample;
+	uint8_t header[44];
+	memcpy(header, "RIFF", 4);
+	write_le32(header + 4, data_size + 36 + (data_size & 1));
+	memcpy(header + 8, "WAVEfmt ", 8);
+	write_le32(header + 16, 16);
+	write_le16(header + 20, 1); // PCM
+	write_le16(header + 22, channels);
+	write_le32(header + 24, sample_rate);
+	write_le32(header + 28, sample_rate * channels * bytes_per_sample);
+	write_le16(header + 32, channels * bytes_per_sample);
+	write_le16(header + 34, bytes_per_sample * 8);
+	memcpy(header + 36, "data", 4);
+	write_le32(header + 40, data_size);
+
+	bool ok = fwrite(header, 1, sizeof(header), file.get()) == sizeof(header);
+
+	// Convert to little endian or 8-bit in blocks
+	uint8_t buffer[8192];
+	const size_t count = frames * channels;
+	for(size_t position = 0; ok && position < count; position += 4096)
+	{
+		size_t length = std::min<size_t>(count - position, 4096);
+		if(bytes_per_sample == 1)
+		{
+			for(size_t i = 0; i < length; i++)
+				buffer[i] = std::min((samples[position + i] + 0x8080) >> 8, 0xff);
+		}
+		else
+		{
+			for(size_t i = 0; i < length; i++)
+				write_le16(buffer + i * 2, samples[position + i]);
+		}
+		ok = fwrite(buffer, bytes_per_sample, length, file.get()) == length;
+	}
+
+	// Chunks are padded to an even size
+	if(ok && (data_size & 1))
+		ok = fputc(0, file.get()) != EOF;
+
+	if(!ok || fclose(file.release()) != 0)
+		throw std::runtime_error("Failed to write " + filename);
+}
+
+//! Convert little-endian PCM samples to signed 16-bit.
+/*!
+ *  Each bit depth is handled by a separate loop without branches, so that
+ *  the compiler can vectorize it.
+ *
+ *  \param count number of samples (not frames) to convert.
+ */
+void convert_pcm(const uint8_t* input, int16_t* output, size_t count, int bits_per_sample, bool is_float)
+{
+	switch(bits_per_sample)
+	{
+		case 8:
+			for(size_t i = 0; i < count; i++)
+				output[i] = (input[i] - 128) * 256;
+			break;
+		case 16:
+			for(size_t i = 0; i < count; i++)
+				output[i] = input[i*2] | (input[i*2+1] << 8);
+			break;
+		case 24:
+			for(size_t i = 0; i < count; i++)
+				output[i] = input[i*3+1] | (input[i*3+2] << 8);
+			break;
+		case 32:
+			if(is_float)
+			{
+				for(size_t i = 0; i < count; i++)
+				{
+					float value;
+					memcpy(&value, &input[i*4], 4);
+					value = std::min(std::max(value * 32768.0f, -32768.0f), 32767.0f);
+					output[i] = (int16_t)value;
+				}
+			}
+			else
+			{
+				for(size_t i = 0; i < count; i++)
+					output[i] = input[i*4+2] | (input[i*4+3] << 8);
+			}
+			break;
+		default:
+			throw std::runtime_error("Unsupported bit depth: " + std::to_string(bits_per_sample));
+	}
+}
+
+//! Mix interleaved samples down to a single channel.
+/*!
+ *  Mono and stereo input get their own loops, since those are by far the
+ *  most common. output may point to the same buffer as input.
+ */
+void downmix_to_mono(const int16_t* input, int16_t* output, size_t frames, int channels)
+{
+	if(channels == 1)
+	{
+		if(output != input)
+			std::copy(input, input + frames, output);
+	}
+	else if(channels == 2)
+	{
+		for(size_t i = 0; i < frames; i++)
+			output[i] = (input[i*2] + input[i*2+1]) / 2;
+	}
+	else if(channels > 2)
+	{
+		for(size_t i = 0; i < frames; i++)
+		{
+			int32_t sum = 0;
+			for(int c = 0; c < channels; c++)
+				sum += input[i*channels + c];
+			output[i] = sum / channels;
+		}
+	}
+}
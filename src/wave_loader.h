@@ -0,0 +1,28 @@
+#ifndef WAVE_LOADER_H
+#define WAVE_LOADER_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+
+//! Decoded PCM audio
+struct Wave_Data
+{
+	std::vector<int16_t> samples; // interleaved
+	uint32_t sample_rate;
+	uint16_t channels;
+
+	//! Get the number of sample frames.
+	inline size_t get_frames() const { return channels ? samples.size() / channels : 0; }
+};
+
+Wave_Data load_wave_file(const std::string& filename);
+Wave_Data load_wave_stream(FILE* file);
+void save_wave_file(const std::string& filename, const int16_t* samples, size_t frames, uint32_t sample_rate, uint16_t channels, int bits_per_sample = 16);
+
+void convert_pcm(const uint8_t* input, int16_t* output, size_t count, int bits_per_sample, bool is_float = false);
+void downmix_to_mono(const int16_t* input, int16_t* output, size_t frames, int channels);
+
+#endif
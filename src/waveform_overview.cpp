@@ -0,0 +1,115 @@
+#include "waveform_overview.h"
+
+#include <algorithm>
+
+const int Waveform_Overview::base_shift = 4;
+const int Waveform_Overview::level_shift = 2;
+
+//! constructs an empty Waveform_Overview
+Waveform_Overview::Waveform_Overview()
+	: data(nullptr)
+	, length(0)
+	, channels(1)
+	, levels()
+{
+}
+
+//! Build the pyramid.
+/*!
+ *  The sample data is not copied. It is shared with the caller and must
+ *  not be modified while the overview uses it.
+ *
+ *  \param data interleaved samples. A trailing partial frame is ignored.
+ *  \param channels the number of interleaved channels.
+ */
+void Waveform_Overview::build(std::shared_ptr<const std::vector<int16_t>> data, int channels)
+{
+	this->data = std::move(data);
+	this->channels = std::max(channels, 1);
+	length = this->data ? this->data->size() / this->channels : 0;
+	levels.clear();
+
+	// First level from the samples
+	size_t block_size = 1 << base_shift;
+	if(length <= block_size)
+		return;
+	const int16_t* samples = this->data->data();
+	std::vector<Peak> level((length + block_size - 1) >> base_shift);
+	for(size_t i = 0; i < level.size(); i++)
+	{
+		auto begin = samples + (i << base_shift) * this->channels;
+		auto end = samples + std::min(length, (i + 1) << base_shift) * this->channels;
+		auto minmax = std::minmax_element(begin, end);
+		level[i] = {*minmax.first, *minmax.second};
+	}
+	levels.push_back(std::move(level));
+
+	// Following levels from the previous level
+	while(levels.back().size() > 1)
+	{
+		const std::vector<Peak>& previous = levels.back();
+		size_t ratio = 1 << level_shift;
+		std::vector<Peak> next((previous.size() + ratio - 1) >> level_shift);
+		for(size_t i = 0; i < next.size(); i++)
+		{
+			Peak peak = previous[i << level_shift];
+			size_t end = std::min(previous.size(), (i + 1) << level_shift);
+			for(size_t j = (i << level_shift) + 1; j < end; j++)
+			{
+				peak.min = std::min(peak.min, previous[j].min);
+				peak.max = std::max(peak.max, previous[j].max);
+			}
+			next[i] = peak;
+		}
+		levels.push_back(std::move(next));
+	}
+}
+
+void Waveform_Overview::clear()
+{
+	data.reset();
+	length = 0;
+	channels = 1;
+	levels.clear();
+}
+
+//! Get the minimum and maximum sample in the range of frames [start, end).
+/*!
+ *  Ranges spanning several blocks are rounded out to whole blocks, which
+ *  is not visible at the scale they are drawn at.
+ */
+Waveform_Overview::Peak Waveform_Overview::get_peak(size_t start, size_t end) const
+{
+	end = std::min(end, length);
+	if(start >= end)
+		return {0, 0};
+
+	// Pick the coarsest level where the range covers at least two blocks.
+	size_t span = end - start;
+	int level = -1;
+	int shift = base_shift;
+	while(level + 1 < (int)levels.size() && (span >> shift) >= 2)
+	{
+		level++;
+		shift += level_shift;
+	}
+
+	if(level < 0)
+	{
+		const int16_t* samples = data->data();
+		auto minmax = std::minmax_element(samples + start * channels, samples + end * channels);
+		return {*minmax.first, *minmax.second};
+	}
+
+	shift = base_shift + level * level_shift;
+	const std::vector<Peak>& peaks = levels[level];
+	size_t first = start >> shift;
+	size_t last = std::min(peaks.size(), ((end - 1) >> shift) + 1);
+	Peak peak = peaks[first];
+	for(size_t i = first + 1; i < last; i++)
+	{
+		peak.min = std::min(peak.min, peaks[i].min);
+		peak.max = std::max(peak.max, peaks[i].max);
+	}
+	return peak;
+}
@@ -0,0 +1,51 @@
+#ifndef WAVEFORM_OVERVIEW_H
+#define WAVEFORM_OVERVIEW_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+//! Min/max peak pyramid for drawing long waveforms
+/*!
+ *  Each level stores the minimum and maximum of blocks of samples, with the
+ *  block size growing by a factor of 4 per level. The peak of any range is
+ *  found by reading a handful of entries from the coarsest level whose
+ *  blocks still fit in the range, so the cost per pixel column does not
+ *  depend on the zoom level.
+ *
+ *  Interleaved data with more than one channel is supported. The peaks then
+ *  cover all channels.
+ *
+ *  The overview keeps a reference to the sample data it was built from, so
+ *  it stays valid if the owner replaces its data.
+ */
+class Waveform_Overview
+{
+	public:
+		struct Peak
+		{
+			int16_t min;
+			int16_t max;
+		};
+
+		Waveform_Overview();
+
+		void build(std::shared_ptr<const std::vector<int16_t>> data, int channels = 1);
+		void clear();
+
+		Peak get_peak(size_t start, size_t end) const;
+
+		inline size_t get_length() const { return length; }
+
+	private:
+		const static int base_shift;	// log2 of the smallest block size
+		const static int level_shift;	// log2 of the block size ratio between levels
+
+		std::shared_ptr<const std::vector<int16_t>> data;
+		size_t length;		// in frames
+		int channels;
+		std::vector<std::vector<Peak>> levels;
+};
+
+#endif